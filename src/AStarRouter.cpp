@@ -52,7 +52,7 @@ AStarResult AStarRouter::calculateRoute(const QString &begin, const QString &end
     System *beginSys = findSystemByName(begin);
     System *endSys   = findSystemByName(end);
     if(beginSys && endSys) {
-        AStarCalculator calculator(_systems, *beginSys, *endSys, jumprange);
+        AStarCalculator calculator(_systems, _positions, *beginSys, *endSys, jumprange);
         return calculator.solve();
     }
     return AStarResult();
@@ -65,19 +65,22 @@ AStarCalculator::~AStarCalculator() {
     _nodes.clear();
 }
 
-void AStarCalculator::cylinder(const SystemList &stars, QVector3D vec_from, QVector3D vec_to, float buffer) {
+void AStarCalculator::cylinder(const SystemList &stars, const QVector<QVector3D> &positions, QVector3D vec_from,
+                               QVector3D vec_to, float buffer) {
 
     auto           bufferSquare = buffer * buffer;
-    for(const auto &s: stars) {
-        auto numerator   = QVector3D::crossProduct(s.position() - vec_from, s.position() - vec_to).lengthSquared();
-        auto denominator = (vec_to - vec_from).lengthSquared();
+    auto           denominator  = (vec_to - vec_from).lengthSquared();
+    // Scan the packed positions, only systems inside the cylinder are touched.
+    for(int i = 0; i < positions.size(); i++) {
+        const auto &position = positions[i];
+        auto numerator   = QVector3D::crossProduct(position - vec_from, position - vec_to).lengthSquared();
         auto dist        = numerator / denominator;
         if(dist < bufferSquare) {
-            auto systemNode = new AStarSystemNode(*this, s);
+            auto systemNode = new AStarSystemNode(*this, stars[i]);
             _nodes.push_back(systemNode);
-            if(s.position() == vec_from) {
+            if(position == vec_from) {
                 _start = systemNode;
-            } else if(s.position() == vec_to) {
+            } else if(position == vec_to) {
                 _end = systemNode;
             }
         }
@@ -130,8 +133,60 @@ void AStarRouter::sortSystemList() {
     std::sort(_systems.begin(), _systems.end(), [ ](const System &a, const System &b) {
         return a.name() < b.name();
     });
+    rebuildLookup();
+    endResetModel();
+}
+
+void AStarRouter::mergeSortedSystems(const SystemList &systems) {
+    if(systems.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    SystemList merged;
+    merged.reserve(_systems.size() + systems.size());
+    auto added = systems.constBegin();
     for(auto &system: _systems) {
-        _systemLookup[system.name().toLower()] = &system;
+        while(added != systems.constEnd() && added->name() < system.name()) {
+            merged.push_back(*added++);
+        }
+        if(added != systems.constEnd() && added->name() == system.name()) {
+            ++added;
+        }
+        merged.push_back(std::move(system));
     }
+    while(added != systems.constEnd()) {
+        merged.push_back(*added++);
+    }
+    _systems.swap(merged);
+    rebuildLookup();
     endResetModel();
 }
+
+void AStarRouter::rebuildLookup() {
+    // Sorting moves the System values between list nodes, so the pointers need to be rebuilt.
+    _systemLookup.clear();
+    _systemLookup.reserve(_systems.size());
+    _positions.clear();
+    _positions.reserve(_systems.size());
+    for(auto &system: _systems) {
+        _systemLookup.insertMulti(nameHash(system.name()), &system);
+        _positions.push_back(system.position());
+    }
+    // The valuable system index points into the list too. It's normally built after the list
+    // is final, but if it already exists it has to follow the systems.
+    if(_valuableSystems.size()) {
+        _valuableSystems.build(_systems);
+    }
+}
+
+void AStarRouter::insertSystem(const System &system) {
+    auto it = std::lower_bound(_systems.begin(), _systems.end(), system, [](const System &a, const System &b) {
+        return a.name() < b.name();
+    });
+    const auto row = static_cast<int>(it - _systems.begin());
+    beginInsertRows(QModelIndex(), row, row);
+    _systems.insert(row, system);
+    _positions.insert(row, system.position());
+    _systemLookup.insertMulti(nameHash(system.name()), &_systems[row]);
+    endInsertRows();
+}
@@ -20,6 +20,7 @@
 #include <deps/PathFinder/src/PathFinder.h>
 #include <deps/PathFinder/src/AStar.h>
 #include "System.h"
+#include "ValuableSystemIndex.h"
 
 class AStarRouter;
 
@@ -85,15 +86,16 @@ class AStarCalculator : public QObject {
 Q_OBJECT
 
 public:
-    AStarCalculator(const SystemList &systems, const System &start, const System &end, float jumprange,
-                    QObject *parent = Q_NULLPTR) : QObject(parent), _start(Q_NULLPTR), _end(Q_NULLPTR),
-                                                   _jumpRange(jumprange), _nodes() {
-        cylinder(systems, start.position(), end.position(), 40.0);
+    AStarCalculator(const SystemList &systems, const QVector<QVector3D> &positions, const System &start,
+                    const System &end, float jumprange, QObject *parent = Q_NULLPTR)
+            : QObject(parent), _start(Q_NULLPTR), _end(Q_NULLPTR), _jumpRange(jumprange), _nodes() {
+        cylinder(systems, positions, start.position(), end.position(), 40.0);
     }
 
     virtual ~AStarCalculator();
 
-    void cylinder(const SystemList &stars, QVector3D vec_from, QVector3D vec_to, float buffer);
+    void cylinder(const SystemList &stars, const QVector<QVector3D> &positions, QVector3D vec_from, QVector3D vec_to,
+                  float buffer);
 
     float jumpRange() const {
         return _jumpRange;
@@ -116,22 +118,39 @@ Q_OBJECT
 
 public:
 
-    AStarRouter(QObject *parent = Q_NULLPTR) : QAbstractItemModel(parent), _systems(), _systemLookup() { }
+    AStarRouter(QObject *parent = Q_NULLPTR)
+            : QAbstractItemModel(parent), _systems(), _positions(), _systemLookup(), _valuableSystems() { }
 
 
     virtual ~AStarRouter() {
     }
 
+    // Append a system while loading, sortSystemList() must be called once loading is done.
     void addSystem(const System &system) {
         _systems.push_back(system);
-        _systemLookup[system.name().toLower()] = &_systems.back();
+        _positions.push_back(system.position());
+        _systemLookup.insertMulti(nameHash(system.name()), &_systems.back());
     }
 
+    void addSystem(System &&system) {
+        _positions.push_back(system.position());
+        _systems.push_back(std::move(system));
+        _systemLookup.insertMulti(nameHash(_systems.back().name()), &_systems.back());
+    }
+
+    // Add a system to the sorted list. Existing System pointers remain valid.
+    void insertSystem(const System &system);
+
     AStarResult calculateRoute(const QString &begin, const QString &end, float jumprange);
 
     System *findSystemByName(const QString &name) {
-        auto lowerName = name.toLower();
-        return _systemLookup.contains(lowerName) ? _systemLookup[lowerName] : Q_NULLPTR;
+        const auto hash = nameHash(name);
+        for(auto it = _systemLookup.constFind(hash); it != _systemLookup.constEnd() && it.key() == hash; ++it) {
+            if(!(*it)->name().compare(name, Qt::CaseInsensitive)) {
+                return *it;
+            }
+        }
+        return Q_NULLPTR;
     }
 
     const SystemList &systems() const {
@@ -149,6 +168,26 @@ public:
     virtual QVariant data(const QModelIndex &index, int role) const;
 
     void sortSystemList();
+
+    // Merge systems sorted by name into the sorted list while loading, skipping ones already in
+    // it. Like sortSystemList() this moves the systems around, so it must be done before any
+    // System pointers are handed out. Both rebuild the lookup and the valuable system index.
+    void mergeSortedSystems(const SystemList &systems);
+
+    // Used instead of sortSystemList() when the systems were added in sorted order.
+    void sortedSystemListLoaded() {
+        beginResetModel();
+        endResetModel();
+    }
+
+    void buildValuableSystemIndex() {
+        _valuableSystems.build(_systems);
+    }
+
+    const ValuableSystemIndex &valuableSystems() const {
+        return _valuableSystems;
+    }
+
 protected:
     friend class SystemLoader;
     void reserveSystemSpace(int size) {
@@ -156,8 +195,18 @@ protected:
     }
 
 private:
-    SystemList              _systems;
-    QMap<QString, System *> _systemLookup;
+    // Systems are looked up by a hash of the lowercase name and compared case insensitively,
+    // so no lowercase copy of every system name is kept around.
+    static uint nameHash(const QString &name) {
+        return qHash(name.toLower());
+    }
+
+    void rebuildLookup();
+
+    SystemList               _systems;
+    QVector<QVector3D>       _positions; // Same order as _systems, scanned by AStarCalculator::cylinder()
+    QMultiHash<uint, System *> _systemLookup;
+    ValuableSystemIndex      _valuableSystems;
 };
 
 
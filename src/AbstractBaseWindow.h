@@ -8,7 +8,7 @@
 #include <QMainWindow>
 #include <QCheckBox>
 #include <QRadioButton>
-#include <deps/EDJournalQT/src/JournalWatcher.h>
+#include <QTimer>
 
 #include "System.h"
 #include "AStarRouter.h"
@@ -16,6 +16,7 @@
 #include "TSPWorker.h"
 #include "RouteViewer.h"
 #include "CommanderInfo.h"
+#include "JournalReader.h"
 
 
 class BaseSlots : public QMainWindow {
@@ -24,7 +25,10 @@ Q_OBJECT
 
 public:
     explicit BaseSlots(QWidget *parent)
-            : QMainWindow(parent) {
+            : QMainWindow(parent), _filterUpdateTimer() {
+        _filterUpdateTimer.setSingleShot(true);
+        _filterUpdateTimer.setInterval(250);
+        connect(&_filterUpdateTimer, SIGNAL(timeout()), this, SLOT(updateFilters()));
     }
 
 protected slots:
@@ -44,6 +48,16 @@ protected slots:
     virtual void openMissionTool() {}
 
     virtual void openExplorationTool() {}
+
+protected:
+    // Filter updates caused by journal events are coalesced, so a burst of events recomputes
+    // the filter once.
+    void scheduleFilterUpdate() {
+        _filterUpdateTimer.start();
+    }
+
+private:
+    QTimer _filterUpdateTimer;
 };
 
 
@@ -102,8 +116,16 @@ protected :
         connect(_ui->filterCommander, SIGNAL(activated(const QString &)), this, SLOT(updateFilters()));
     }
 
+    virtual bool hasFilteredSystems() const {
+        return _filteredSystems.size() > 0;
+    }
+
+    virtual TSPWorker *createWorker(System *originSystem, int routeSize) {
+        return new TSPWorker(_filteredSystems, originSystem, routeSize);
+    }
+
     virtual void createRoute() {
-        if(_filteredSystems.size() > 0) {
+        if(hasFilteredSystems()) {
             auto systemName = _ui->systemName->text();
             auto originSystem = _router->findSystemByName(systemName);
             if(!originSystem) {
@@ -116,10 +138,10 @@ protected :
             updateSystemCoordinateDisplay(*originSystem);
             showMessage(QString("Calculating route with %1 systems starting at %2...").arg(routeSize).arg(originSystem->name()),0);
             _ui->createRouteButton->setEnabled(false);
-            TSPWorker *workerThread(new TSPWorker(_filteredSystems, originSystem, routeSize));
+            TSPWorker *workerThread(createWorker(originSystem, routeSize));
             workerThread->setSystemsOnly(_systemsOnly);
             // workerThread->setRouter(_router);
-            connect(workerThread, &QThread::finished, workerThread, &QObject::deleteLater);
+            connect(workerThread, &WorkerTask::finished, workerThread, &QObject::deleteLater);
             connect(workerThread, &TSPWorker::taskCompleted, this, &AbstractBaseWindow::routeCalculated);
             _ui->centralWidget->setEnabled(false);
             onRouterCreated(workerThread);
@@ -143,15 +165,16 @@ protected :
         _ui->createRouteButton->setEnabled(true);
     }
 
-    bool updateCommanderInfo(const JournalFile &file, const Event &ev, const QString &commander) {
+    bool updateCommanderInfo(const JournalEvent &event) {
+        const auto &commander = event._context._commander;
         CommanderInfo info;
         if(_commanderInformation.contains(commander)) {
             info = _commanderInformation[commander];
         }
 
-        if(ev.timestamp() > info._lastEventDate) {
-            info._lastEventDate = ev.timestamp();
-            info._system = file.system();
+        if(event._timestamp > info._lastEventDate) {
+            info._lastEventDate = event._timestamp;
+            info._system = event._context._system;
             _commanderInformation[commander] = info;
             if(_ui->filterCommander->findText(commander) < 0) {
                 _ui->filterCommander->addItem(commander);
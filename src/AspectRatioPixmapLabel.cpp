@@ -36,9 +36,13 @@ void AspectRatioPixmapLabel::paintEvent(QPaintEvent *event) {
     QSize pixSize = _pixmap.size();
     pixSize.scale(size(), Qt::KeepAspectRatio);
 
-    QPixmap scaledPix = _pixmap.scaled(pixSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    // Smooth scaling is slow on large maps, only redo it when the size changes.
+    if(_scaledSize != pixSize) {
+        _scaledPixmap = _pixmap.scaled(pixSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        _scaledSize = pixSize;
+    }
     QPoint pt(0, (size().height()-pixSize.height())/2);
-    painter.drawPixmap(pt, scaledPix);
+    painter.drawPixmap(pt, _scaledPixmap);
 }
 
 
@@ -52,6 +56,8 @@ const QPixmap *AspectRatioPixmapLabel::pixmap() const {
 
 void AspectRatioPixmapLabel::setPixmap(const QPixmap &pixmap) {
     _pixmap = pixmap;
+    _scaledPixmap = QPixmap();
+    _scaledSize = QSize();
     repaint();
 }
 
@@ -40,4 +40,6 @@ protected:
 
 private:
     QPixmap _pixmap;
+    QPixmap _scaledPixmap; // _pixmap scaled to _scaledSize, the last painted size
+    QSize _scaledSize;
 };
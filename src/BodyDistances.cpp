@@ -0,0 +1,57 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstring>
+#include <QFile>
+#include "BodyDistances.h"
+
+bool BodyDistances::load(const QString &path) {
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    parse(file.readAll());
+    return true;
+}
+
+void BodyDistances::parse(const QByteArray &data) {
+    _distances.clear();
+    _distances.reserve(data.count('\n') + 1);
+    const char *pos = data.constData();
+    const char *end = pos + data.size();
+    while(pos < end) {
+        auto lineEnd = static_cast<const char *>(memchr(pos, '\n', end - pos));
+        if(!lineEnd) {
+            lineEnd = end;
+        }
+        auto planetStart = static_cast<const char *>(memchr(pos, '\t', lineEnd - pos));
+        auto distanceStart = planetStart
+                             ? static_cast<const char *>(memchr(planetStart + 1, '\t', lineEnd - planetStart - 1))
+                             : nullptr;
+        if(distanceStart) {
+            const auto system = QString::fromUtf8(pos, static_cast<int>(planetStart - pos));
+            const auto planet = QString::fromUtf8(planetStart + 1, static_cast<int>(distanceStart - planetStart - 1));
+            int32 distance = 0;
+            for(auto digit = distanceStart + 1; digit < lineEnd && *digit >= '0' && *digit <= '9'; ++digit) {
+                distance = distance * 10 + (*digit - '0');
+            }
+            if(distance) {
+                _distances.insert(key(system, planet), distance);
+            }
+        }
+        pos = lineEnd + 1;
+    }
+}
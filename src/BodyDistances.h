@@ -0,0 +1,54 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <base/integral_types.h>
+
+// Distance to arrival (in ls) for the bodies that have settlements. The data comes from
+// body_distances.tsv, one "system<TAB>planet<TAB>distance" line per body as emitted by the
+// bodydistance tool. Entries are keyed on the hashes of the two names only.
+class BodyDistances {
+public:
+    BodyDistances() : _distances() { }
+
+    bool load(const QString &path);
+
+    void parse(const QByteArray &data);
+
+    // Returns 0 for unknown bodies.
+    int32 distance(const QString &system, const QString &planet) const {
+        return _distances.value(key(system, planet), 0);
+    }
+
+    int size() const {
+        return _distances.size();
+    }
+
+    void clear() {
+        _distances.clear();
+    }
+
+    static quint64 key(const QString &system, const QString &planet) {
+        return (static_cast<quint64>(qHash(system)) << 32) | qHash(planet);
+    }
+
+private:
+    QHash<quint64, int32> _distances;
+};
@@ -0,0 +1,79 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cstring>
+#include "CoordinateIndex.h"
+
+bool CoordinateIndex::open(const QString &path) {
+    _file.setFileName(path);
+    if(!_file.open(QIODevice::ReadOnly) || !_file.size()) {
+        return false;
+    }
+    _size = _file.size();
+    _data = reinterpret_cast<const char *>(_file.map(0, _size));
+    if(!_data) {
+        _file.close();
+        _size = 0;
+    }
+    return _data != nullptr;
+}
+
+bool CoordinateIndex::find(const QString &systemName, QString &name, QVector3D &position) const {
+    if(!_data) {
+        return false;
+    }
+    const auto wanted = key(systemName);
+    // Binary search over byte offsets. Each probe is moved back to the start of its line, and
+    // the range shrinks to either after or before that line.
+    qint64 low = 0;
+    qint64 high = _size;
+    while(low < high) {
+        const auto middle = low + (high - low) / 2;
+        auto lineStart = middle;
+        while(lineStart > low && _data[lineStart - 1] != '\n') {
+            --lineStart;
+        }
+        auto lineEnd = static_cast<const char *>(memchr(_data + middle, '\n', static_cast<size_t>(_size - middle)));
+        const auto lineEndOffset = lineEnd ? lineEnd - _data : _size;
+        auto keyEnd = static_cast<const char *>(memchr(_data + lineStart, '\t',
+                                                      static_cast<size_t>(lineEndOffset - lineStart)));
+        if(!keyEnd) {
+            return false; // Not an index file.
+        }
+        const auto keyLength = static_cast<size_t>(keyEnd - (_data + lineStart));
+        auto compare = memcmp(_data + lineStart, wanted.constData(),
+                              qMin(keyLength, static_cast<size_t>(wanted.size())));
+        if(!compare) {
+            compare = keyLength < static_cast<size_t>(wanted.size()) ? -1 : keyLength > static_cast<size_t>(wanted.size());
+        }
+        if(compare < 0) {
+            low = lineEndOffset + 1;
+        } else if(compare > 0) {
+            high = lineStart;
+        } else {
+            const auto fields = QByteArray::fromRawData(keyEnd + 1, static_cast<int>(_data + lineEndOffset - keyEnd - 1))
+                    .split('\t');
+            if(fields.size() < 4) {
+                return false;
+            }
+            name = QString::fromUtf8(fields[0]);
+            position = QVector3D(fields[1].toFloat(), fields[2].toFloat(), fields[3].toFloat());
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,52 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QVector3D>
+
+// Read only view of an on-disk system coordinate index, as written by the systemdata tool from
+// an EDSM systems dump. The file has one "key<TAB>name<TAB>x<TAB>y<TAB>z" line per system,
+// sorted bytewise by key, which is the lowercased UTF-8 name. It is memory mapped and searched
+// in place, so even an index of the full dump opens instantly and uses no heap.
+class CoordinateIndex {
+public:
+    CoordinateIndex() : _file(), _data(nullptr), _size(0) { }
+
+    bool open(const QString &path);
+
+    bool isOpen() const {
+        return _data != nullptr;
+    }
+
+    // Looks up a system by name, in any case. The name is returned as spelled in the index.
+    bool find(const QString &systemName, QString &name, QVector3D &position) const;
+
+    // The key the index is sorted by.
+    static QByteArray key(const QString &systemName) {
+        return systemName.toLower().toUtf8();
+    }
+
+private:
+    Q_DISABLE_COPY(CoordinateIndex)
+
+    QFile _file;
+    const char *_data;
+    qint64 _size;
+};
@@ -0,0 +1,206 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include "CoordinateService.h"
+#include "EDSMQueryExecutor.h"
+
+#define COORDINATE_CACHE_MAGIC 0x45444343
+#define COORDINATE_CACHE_VERSION 1
+// The least recently used systems are dropped beyond this.
+#define COORDINATE_CACHE_MAX_SYSTEMS 5000
+// Unknown systems are looked up again after this, in case they've been added to EDSM since.
+#define COORDINATE_CACHE_FAILURE_TTL_SECS (24 * 60 * 60)
+#define COORDINATE_CACHE_SAVE_DELAY_MS 10000
+// Systems per EDSM request, which keeps the URLs to a reasonable length.
+#define EDSM_BATCH_SIZE 50
+
+CoordinateService *CoordinateService::instance() {
+    static CoordinateService *service = new CoordinateService(QCoreApplication::instance());
+    return service;
+}
+
+CoordinateService::CoordinateService(QObject *parent)
+        : QObject(parent), _index(), _networkEnabled(true), _edsmUrl(), _cache(), _failures(), _saveTimer() {
+    QSettings settings;
+    const auto defaultIndex = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/systems.index";
+    _index.open(settings.value("coordinates/index", defaultIndex).toString());
+    _networkEnabled = settings.value("coordinates/network", true).toBool();
+    _edsmUrl = settings.value("coordinates/edsmUrl", "https://www.edsm.net").toString();
+
+    _saveTimer.setSingleShot(true);
+    _saveTimer.setInterval(COORDINATE_CACHE_SAVE_DELAY_MS);
+    connect(&_saveTimer, &QTimer::timeout, this, &CoordinateService::save);
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &CoordinateService::save);
+    load();
+}
+
+void CoordinateService::lookup(const QStringList &systemNames) {
+    QStringList remote;
+    for(const auto &systemName: systemNames) {
+        if(!resolveLocally(systemName)) {
+            remote.push_back(systemName);
+        }
+    }
+    for(int i = 0; i < remote.size(); i += EDSM_BATCH_SIZE) {
+        auto executor = EDSMQueryExecutor::systemCoordinateRequest(_edsmUrl, remote.mid(i, EDSM_BATCH_SIZE));
+        connect(executor, &EDSMQueryExecutor::finished, executor, &QObject::deleteLater);
+        connect(executor, &EDSMQueryExecutor::coordinatesReceived, this, &CoordinateService::cacheSystem);
+        connect(executor, &EDSMQueryExecutor::coordinatesReceived, this, &CoordinateService::coordinatesReceived);
+        connect(executor, &EDSMQueryExecutor::systemNotFound, this, &CoordinateService::cacheFailure);
+        connect(executor, &EDSMQueryExecutor::coordinateRequestFailed, this,
+                &CoordinateService::coordinateRequestFailed);
+        executor->start();
+    }
+}
+
+bool CoordinateService::resolveLocally(const QString &systemName) {
+    const auto key = systemName.toLower();
+    QString name;
+    QVector3D position;
+    auto cached = _cache.find(key);
+    if(cached != _cache.end()) {
+        cached->_lastUsed = QDateTime::currentDateTimeUtc();
+        const System system(cached->_name, cached->_position);
+        QTimer::singleShot(0, this, [this, system]() {
+            emit coordinatesReceived(system);
+        });
+    } else if(_index.find(systemName, name, position)) {
+        const System system(name, position);
+        QTimer::singleShot(0, this, [this, system]() {
+            emit coordinatesReceived(system);
+        });
+    } else if(!_networkEnabled || (_failures.contains(key) &&
+              _failures[key].secsTo(QDateTime::currentDateTimeUtc()) < COORDINATE_CACHE_FAILURE_TTL_SECS)) {
+        QTimer::singleShot(0, this, [this, systemName]() {
+            emit coordinateRequestFailed(systemName);
+        });
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SystemList CoordinateService::cachedSystems() const {
+    SystemList systems;
+    systems.reserve(_cache.size());
+    for(const auto &cached: _cache) {
+        systems.push_back(System(cached._name, cached._position));
+    }
+    std::sort(systems.begin(), systems.end(), [](const System &a, const System &b) {
+        return a.name() < b.name();
+    });
+    return systems;
+}
+
+void CoordinateService::markUsed(const QString &systemName) {
+    auto cached = _cache.find(systemName.toLower());
+    if(cached != _cache.end()) {
+        cached->_lastUsed = QDateTime::currentDateTimeUtc();
+        _saveTimer.start();
+    }
+}
+
+void CoordinateService::cacheSystem(const System &system) {
+    const auto key = system.name().toLower();
+    _failures.remove(key);
+    _cache[key] = {system.name(), system.position(), QDateTime::currentDateTimeUtc()};
+    if(_cache.size() > COORDINATE_CACHE_MAX_SYSTEMS) {
+        auto oldest = _cache.begin();
+        for(auto it = _cache.begin(); it != _cache.end(); ++it) {
+            if(it->_lastUsed < oldest->_lastUsed) {
+                oldest = it;
+            }
+        }
+        _cache.erase(oldest);
+    }
+    _saveTimer.start();
+}
+
+void CoordinateService::cacheFailure(const QString &systemName) {
+    _failures[systemName.toLower()] = QDateTime::currentDateTimeUtc();
+    _saveTimer.start();
+}
+
+QString CoordinateService::cachePath() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/coordinates.cache";
+}
+
+void CoordinateService::load() {
+    QFile file(cachePath());
+    if(!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    quint32 magic, version;
+    qint32 count;
+    stream >> magic >> version >> count;
+    if(magic != COORDINATE_CACHE_MAGIC || version != COORDINATE_CACHE_VERSION || count < 0) {
+        return;
+    }
+    QHash<QString, CachedSystem> cache;
+    for(qint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        CachedSystem cached;
+        stream >> cached._name >> cached._position >> cached._lastUsed;
+        cache[cached._name.toLower()] = cached;
+    }
+    QHash<QString, QDateTime> failures;
+    stream >> failures;
+    if(stream.status() != QDataStream::Ok) {
+        return;
+    }
+    // Expired failures are dropped here rather than kept around until they're looked up again.
+    const auto now = QDateTime::currentDateTimeUtc();
+    for(auto it = failures.begin(); it != failures.end();) {
+        if(it.value().secsTo(now) >= COORDINATE_CACHE_FAILURE_TTL_SECS) {
+            it = failures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    _cache = cache;
+    _failures = failures;
+}
+
+void CoordinateService::save() {
+    _saveTimer.stop();
+    if(!QDir().mkpath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))) {
+        return;
+    }
+    QSaveFile file(cachePath());
+    if(!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << static_cast<quint32>(COORDINATE_CACHE_MAGIC) << static_cast<quint32>(COORDINATE_CACHE_VERSION)
+           << static_cast<qint32>(_cache.size());
+    for(const auto &cached: _cache) {
+        stream << cached._name << cached._position << cached._lastUsed;
+    }
+    stream << _failures;
+    if(stream.status() == QDataStream::Ok) {
+        file.commit();
+    }
+}
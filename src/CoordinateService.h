@@ -0,0 +1,96 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+#include "CoordinateIndex.h"
+#include "System.h"
+
+// Looks up coordinates of systems that aren't in the bundled system list. A local index built
+// from an EDSM systems dump is used when there is one, with the EDSM API (or anything serving
+// the same API) as the fallback. Both are configured in the application settings:
+//
+//   coordinates/index    Path of the local index (default systems.index in the data directory).
+//   coordinates/network  Whether to fall back to the network at all (default true).
+//   coordinates/edsmUrl  Base URL of the EDSM API (default https://www.edsm.net).
+//
+// Systems found through the network are kept in a persistent cache, which is loaded into the
+// router at startup, and systems EDSM doesn't know are not asked for again for a day.
+class CoordinateService : public QObject {
+Q_OBJECT
+
+public:
+    static CoordinateService *instance();
+
+    // Results are always delivered asynchronously, through coordinatesReceived() or
+    // coordinateRequestFailed().
+    void lookup(const QString &systemName) {
+        lookup(QStringList(systemName));
+    }
+
+    // Systems that have to come from the network are looked up in as few requests as possible.
+    void lookup(const QStringList &systemNames);
+
+    // The cached systems, sorted by name.
+    SystemList cachedSystems() const;
+
+    // Cached systems are loaded into the router at startup and found there afterwards, so the
+    // places that use a system for routing report it here. When the cache is full, the system
+    // used least recently is dropped.
+    void markUsed(const QString &systemName);
+
+public slots:
+
+    void save();
+
+signals:
+
+    void coordinatesReceived(const System &system);
+
+    void coordinateRequestFailed(const QString &systemName);
+
+private:
+    struct CachedSystem {
+        QString _name;
+        QVector3D _position;
+        QDateTime _lastUsed;
+    };
+
+    explicit CoordinateService(QObject *parent);
+
+    // Emits the result right away (on the next event loop pass) if the network isn't needed.
+    bool resolveLocally(const QString &systemName);
+
+    void cacheSystem(const System &system);
+
+    void cacheFailure(const QString &systemName);
+
+    void load();
+
+    static QString cachePath();
+
+    CoordinateIndex _index;
+    bool _networkEnabled;
+    QString _edsmUrl;
+    QHash<QString, CachedSystem> _cache; // By lowercase name
+    QHash<QString, QDateTime> _failures; // Lowercase name and when EDSM last didn't know it
+    QTimer _saveTimer;
+};
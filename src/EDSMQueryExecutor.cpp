@@ -15,63 +15,60 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
-#include <QEventLoop>
-#include <QNetworkRequest>
-#include <QNetworkReply>
+#include <QJsonArray>
 #include <QJsonDocument>
+#include <QSet>
 
 #include "EDSMQueryExecutor.h"
+#include "NetworkService.h"
 #include "System.h"
 #include <QJsonObject>
 
-#define SYSTEM_QUERY_URL QString("https://www.edsm.net/api-v1/system?systemName=%1&coords=1")
+#define SYSTEMS_QUERY_PATH QString("/api-v1/systems?showCoordinates=1")
 
-EDSMQueryExecutor *EDSMQueryExecutor::systemCoordinateRequest(const QString &systemName) {
-    auto queryString = SYSTEM_QUERY_URL.arg(QString(QUrl::toPercentEncoding(systemName)));
-    return new EDSMQueryExecutor(QUrl(queryString), Coordinates, systemName);
+EDSMQueryExecutor *EDSMQueryExecutor::systemCoordinateRequest(const QString &baseUrl, const QStringList &systemNames) {
+    auto queryString = baseUrl + SYSTEMS_QUERY_PATH;
+    for(const auto &systemName: systemNames) {
+        queryString += "&systemName[]=" + QString(QUrl::toPercentEncoding(systemName));
+    }
+    return new EDSMQueryExecutor(QUrl(queryString), Coordinates, systemNames);
 }
 
-void EDSMQueryExecutor::run() {
-    QNetworkRequest request;
-    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QVariant(int(QNetworkRequest::AlwaysNetwork)));
-    request.setUrl(_url);
-    _mgr = new QNetworkAccessManager();
-    QNetworkReply *pReply = _mgr->get(request);
-    connect(_mgr, SIGNAL(finished(QNetworkReply * )), this, SLOT(replyFinished(QNetworkReply * )));
-
-    QEventLoop eLoop;
-    QObject::connect(pReply, SIGNAL(finished()), &eLoop, SLOT(quit()));
-    eLoop.exec(QEventLoop::ExcludeUserInputEvents);
+void EDSMQueryExecutor::start() {
+    // Someone is waiting on the lookup, it goes ahead of image downloads.
+    _reply = NetworkService::instance()->get(_url, this, QNetworkRequest::AlwaysNetwork, TaskPriorityInteractive);
+    connect(_reply, &NetworkReply::finished, this, &EDSMQueryExecutor::replyFinished);
 }
 
-void EDSMQueryExecutor::replyFinished(QNetworkReply *reply) {
-    if(reply->error() == QNetworkReply::NoError && reply->isReadable()) {
-        auto data     = reply->readAll();
-        auto document = QJsonDocument::fromJson(data);
-        if(document.isObject()) {
-            emit coordinatesReceived(System(document.object()));
-            reply->deleteLater();
+void EDSMQueryExecutor::replyFinished() {
+    if(_reply->isOk()) {
+        auto document = QJsonDocument::fromJson(_reply->data());
+        if(document.isArray()) {
+            // Only the systems EDSM knows are in the response.
+            QSet<QString> found;
+            for(const auto &value: document.array()) {
+                const System system(value.toObject());
+                if(!system.name().isEmpty()) {
+                    found.insert(system.name().toLower());
+                    emit coordinatesReceived(system);
+                }
+            }
+            for(const auto &systemName: _systemNames) {
+                if(!found.contains(systemName.toLower())) {
+                    emit systemNotFound(systemName);
+                    emit coordinateRequestFailed(systemName);
+                }
+            }
+            emit finished();
             return;
         }
     }
-    emit coordinateRequestFailed(_systemName);
-    reply->deleteLater();
-}
-
-EDSMQueryExecutor::~EDSMQueryExecutor() {
-    if(_mgr) { _mgr->deleteLater(); }
+    for(const auto &systemName: _systemNames) {
+        emit coordinateRequestFailed(systemName);
+    }
+    emit finished();
 }
 
-EDSMQueryExecutor::EDSMQueryExecutor(const QUrl &url, RequestType requestType, const QString &systemName)
-        : QThread(Q_NULLPTR), _mgr(nullptr),
-          _requestType(requestType), _url(url), _systemName(systemName) {
+EDSMQueryExecutor::EDSMQueryExecutor(const QUrl &url, RequestType requestType, const QStringList &systemNames)
+        : QObject(), _reply(nullptr), _requestType(requestType), _url(url), _systemNames(systemNames) {
 }
-
-
-
-
-
-
-
-
-
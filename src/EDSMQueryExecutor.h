@@ -16,46 +16,52 @@
 //
 #pragma once
 
+#include <QObject>
+#include <QStringList>
 #include <QUrl>
-#include <QThread>
 
-class QNetworkReply;
-
-class QNetworkAccessManager;
+class NetworkReply;
 
 class System;
 
-class EDSMQueryExecutor : public QThread {
+// A request to the EDSM API, made through NetworkService. The reply is parsed on the thread
+// the executor lives on, finished() is emitted after the results.
+class EDSMQueryExecutor : public QObject {
 Q_OBJECT
 
 public:
 
-    static EDSMQueryExecutor *systemCoordinateRequest(const QString &systemName);
-
-    virtual ~EDSMQueryExecutor() override;
+    // Looks up any number of systems in one request. baseUrl is the EDSM server, e.g.
+    // https://www.edsm.net. Every system is reported with either coordinatesReceived() or
+    // coordinateRequestFailed().
+    static EDSMQueryExecutor *systemCoordinateRequest(const QString &baseUrl, const QStringList &systemNames);
 
-protected:
-    virtual void run() override;
+    void start();
 
 signals:
 
+    void finished();
+
     void coordinatesReceived(const System &);
 
     void coordinateRequestFailed(const QString &);
 
-public slots:
+    // EDSM answered, but doesn't know the system. Emitted in addition to coordinateRequestFailed().
+    void systemNotFound(const QString &);
+
+private slots:
 
-    void replyFinished(QNetworkReply *reply);
+    void replyFinished();
 
 private:
     enum RequestType {
         Coordinates
     };
 
-    explicit EDSMQueryExecutor(const QUrl &url, RequestType requestType, const QString &systemName);
+    explicit EDSMQueryExecutor(const QUrl &url, RequestType requestType, const QStringList &systemNames);
 
-    QNetworkAccessManager *_mgr;
+    NetworkReply          *_reply;
     RequestType           _requestType;
     const QUrl            _url;
-    const QString         _systemName;
+    const QStringList     _systemNames;
 };
@@ -15,38 +15,78 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
-#include <QPixmap>
-#include <QStandardPaths>
+#include <QDebug>
 #include <QNetworkDiskCache>
+#include <QPixmap>
+#include <QPixmapCache>
+#include <QScopedPointer>
+#include <QtConcurrent>
 #include "ImageLoader.h"
 #include "AspectRatioPixmapLabel.h"
 #include "ImageViewer.h"
+#include "NetworkService.h"
+#include "TaskScheduler.h"
+
+// Room for the icons and scaled maps of a few dozen settlement types.
+#define PIXMAP_CACHE_LIMIT_KB (64 * 1024)
 
 ImageLoader::~ImageLoader() {
-     if(_reply) {
-         _reply->abort();
-     }
-    delete _networkManager;
 }
 
-void ImageLoader::onNetworkReplyReceived(QNetworkReply *reply) {
-    if(reply->error() != QNetworkReply::NoError) {
-        qDebug() << "Error in" << reply->url() << ":" << reply->errorString();
+void ImageLoader::onNetworkReplyReceived() {
+    if(!_reply->isOk()) {
+        qDebug() << "Error in" << _reply->url() << ":" << _reply->errorString();
+        finish();
         return;
     }
-    QVariant attribute = reply->attribute(QNetworkRequest::RedirectionTargetAttribute);
-    if(attribute.isValid()) {
-        QUrl url     = attribute.toUrl();
-        auto request = QNetworkRequest(url);
-        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
-        _reply = _networkManager->get(request);
+    loadPixmap(_reply->data());
+}
+
+QString ImageLoader::cacheKey(const QUrl &url, const QSize &maxSize) {
+    return QString("%1@%2x%3").arg(url.toString()).arg(maxSize.width()).arg(maxSize.height());
+}
+
+QImage ImageLoader::decodeImage(const QByteArray &data, const QSize &maxSize) {
+    auto image = QImage::fromData(data);
+    if(maxSize.isValid() && (image.width() > maxSize.width() || image.height() > maxSize.height())) {
+        image = image.scaled(maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return image;
+}
+
+void ImageLoader::loadPixmap(const QByteArray &data) {
+    delete _decoder;
+    _decoder = new QFutureWatcher<QImage>(this);
+    connect(_decoder, SIGNAL(finished()), this, SLOT(onImageDecoded()));
+    _decoder->setFuture(QtConcurrent::run(TaskScheduler::instance()->pool(), &ImageLoader::decodeImage, data, _maxSize));
+}
+
+void ImageLoader::onImageDecoded() {
+    const auto image = _decoder->result();
+    if(image.isNull() && !_reply) {
+        // The disk cache copy didn't decode. Drop it, or the download would be served from it.
+        NetworkService::instance()->cache()->remove(_url);
+        requestImage();
         return;
     }
-    //qDebug() << "ContentType:" << reply->header(QNetworkRequest::ContentTypeHeader).toString();
-    QByteArray data = reply->readAll();
-    QPixmap    pixmap;
-    pixmap.loadFromData(data);
-    updateLabelWithPixmap(pixmap);
+    if(!image.isNull()) {
+        const auto pixmap = QPixmap::fromImage(image);
+        QPixmapCache::insert(cacheKey(_url, _maxSize), pixmap);
+        updateLabelWithPixmap(pixmap);
+    }
+    finish();
+}
+
+void ImageLoader::requestImage() {
+    _reply = NetworkService::instance()->get(_url, this, QNetworkRequest::PreferCache,
+                                             _prefetch ? TaskPriorityBackground : TaskPriorityNormal);
+    connect(_reply, SIGNAL(finished()), this, SLOT(onNetworkReplyReceived()));
+}
+
+void ImageLoader::finish() {
+    if(_prefetch) {
+        deleteLater();
+    }
 }
 
 void ImageLoader::updateLabelWithPixmap(const QPixmap &pixmap) const {
@@ -64,26 +104,40 @@ void ImageLoader::updateLabelWithPixmap(const QPixmap &pixmap) const {
 }
 
 
+void ImageLoader::prefetch(const QUrl &url, const QSize &maxSize, QObject *owner) {
+    if(url.isEmpty() || QPixmapCache::find(cacheKey(url, maxSize), nullptr)) {
+        return;
+    }
+    auto loader = new ImageLoader(nullptr);
+    loader->setParent(owner);
+    loader->setMaxSize(maxSize);
+    loader->_prefetch = true;
+    loader->startDownload(url);
+}
+
 void ImageLoader::startDownload(const QUrl &url) {
-    auto data = _networkManager->cache()->data(url);
+    delete _reply;
+    _reply = nullptr;
+    delete _decoder;
+    _decoder = nullptr;
+    _url = url;
+    QPixmap pixmap;
+    if(QPixmapCache::find(cacheKey(url, _maxSize), &pixmap)) {
+        updateLabelWithPixmap(pixmap);
+        finish();
+        return;
+    }
+    QScopedPointer<QIODevice> data(NetworkService::instance()->cache()->data(url));
     if(data) {
-        QPixmap pixmap;
-        pixmap.loadFromData(data->readAll());
-        if(!pixmap.isNull()) {
-            updateLabelWithPixmap(pixmap);
-            return;
-        }
+        loadPixmap(data->readAll());
+    } else {
+        requestImage();
     }
-
-    QNetworkRequest request(url);
-    _reply = _networkManager->get(request);
 }
 
-ImageLoader::ImageLoader(QWidget *pixmapHolder) : _maxSize(QSize()), _networkManager(new QNetworkAccessManager(this)), _reply(nullptr), _pixmapHolder(pixmapHolder) {
-    connect(_networkManager, SIGNAL(finished(QNetworkReply*)), this, SLOT(onNetworkReplyReceived(QNetworkReply *)));
-
-    auto cachePath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation).append("/imagecache");
-    auto cache = new QNetworkDiskCache();
-    cache->setCacheDirectory(cachePath);
-    _networkManager->setCache(cache);
+ImageLoader::ImageLoader(QWidget *pixmapHolder)
+        : _maxSize(QSize()), _reply(nullptr), _decoder(nullptr), _pixmapHolder(pixmapHolder), _url(), _prefetch(false) {
+    if(QPixmapCache::cacheLimit() < PIXMAP_CACHE_LIMIT_KB) {
+        QPixmapCache::setCacheLimit(PIXMAP_CACHE_LIMIT_KB);
+    }
 }
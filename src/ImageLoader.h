@@ -15,12 +15,13 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
-#include <QNetworkAccessManager>
+#include <QFutureWatcher>
+#include <QImage>
 #include <QUrl>
-#include <QNetworkRequest>
-#include <QNetworkReply>
 #include <QLabel>
 
+class NetworkReply;
+
 class ImageLoader: public QObject {
 Q_OBJECT
 
@@ -29,18 +30,39 @@ public:
     virtual ~ImageLoader();
     void startDownload(const QUrl &url);
 
+    // Downloads and decodes url into the pixmap cache without showing it. The loader is owned
+    // by owner and deletes itself when done.
+    static void prefetch(const QUrl &url, const QSize &maxSize, QObject *owner);
+
     void setMaxSize(const QSize &maxSize) {
         _maxSize = maxSize;
     }
 
 private slots:
-    void onNetworkReplyReceived(QNetworkReply *reply);
+    void onNetworkReplyReceived();
+
+    void onImageDecoded();
 
 private:
     QSize _maxSize;
-    QNetworkAccessManager *_networkManager;
-    QNetworkReply *_reply;
+    NetworkReply *_reply;
+    QFutureWatcher<QImage> *_decoder;
     QWidget *_pixmapHolder;
+    QUrl _url;
+    bool _prefetch;
+
+    // Decoded images are kept in QPixmapCache under the URL and the size they were scaled to.
+    static QString cacheKey(const QUrl &url, const QSize &maxSize);
+
+    // Decoding and scaling run in the worker pool, only the conversion to a pixmap is done on
+    // the GUI thread.
+    static QImage decodeImage(const QByteArray &data, const QSize &maxSize);
+
+    void loadPixmap(const QByteArray &data);
+
+    void requestImage();
+
+    void finish();
 
     void updateLabelWithPixmap(const QPixmap &pixmap) const;
 };
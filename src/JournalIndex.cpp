@@ -0,0 +1,301 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include "JournalIndex.h"
+#include "SettlementIndex.h"
+#include "TaskScheduler.h"
+
+#define JOURNAL_INDEX_MAGIC 0x45444a49
+// Bump whenever the stream layout or the event handling changes.
+#define JOURNAL_INDEX_VERSION 2
+
+void JournalState::apply(const JournalEvent &event) {
+    const auto &commander = event._context._commander;
+    const auto &system = event._context._system;
+    if(commander.isEmpty()) {
+        return;
+    }
+    switch(event._type) {
+    case JournalEventLocation:
+    case JournalEventFSDJump: {
+        if(system.isEmpty()) {
+            break;
+        }
+        auto &info = _commanders[commander];
+        if(event._timestamp > info._lastEventDate) {
+            info._lastEventDate = event._timestamp;
+            info._system = system;
+        }
+        _exploredSystems[commander];
+        break;
+    }
+    case JournalEventScan:
+        if(!system.isEmpty()) {
+            _exploredSystems[commander].insert(system.toUpper());
+        }
+        break;
+    case JournalEventDatalinkScan:
+        for(const auto &key: settlementKeys(event)) {
+            auto &scanDate = _settlementScans[commander][key];
+            if(scanDate < event._timestamp) {
+                scanDate = event._timestamp;
+            }
+        }
+        break;
+    case JournalEventMissionAccepted:
+        if(!event._destination.isEmpty() && event._destination != system) {
+            _missions[commander][event._missionId] = {event._destination, system, event._expiry};
+        }
+        break;
+    case JournalEventMissionAbandoned:
+    case JournalEventMissionFailed:
+    case JournalEventMissionCompleted:
+        _missions[commander].remove(event._missionId);
+        _closedMissions[commander].insert(event._missionId);
+        break;
+    default:
+        break;
+    }
+}
+
+void JournalState::merge(const JournalState &later) {
+    for(auto it = later._exploredSystems.constBegin(); it != later._exploredSystems.constEnd(); ++it) {
+        _exploredSystems[it.key()].unite(it.value());
+    }
+    for(auto it = later._commanders.constBegin(); it != later._commanders.constEnd(); ++it) {
+        auto &info = _commanders[it.key()];
+        if(it.value()._lastEventDate > info._lastEventDate) {
+            info = it.value();
+        }
+    }
+    for(auto it = later._settlementScans.constBegin(); it != later._settlementScans.constEnd(); ++it) {
+        auto &scans = _settlementScans[it.key()];
+        for(auto scan = it.value().constBegin(); scan != it.value().constEnd(); ++scan) {
+            auto &scanDate = scans[scan.key()];
+            if(scanDate < scan.value()) {
+                scanDate = scan.value();
+            }
+        }
+    }
+    for(auto it = later._closedMissions.constBegin(); it != later._closedMissions.constEnd(); ++it) {
+        auto &missions = _missions[it.key()];
+        for(auto id: it.value()) {
+            missions.remove(id);
+        }
+        _closedMissions[it.key()].unite(it.value());
+    }
+    for(auto it = later._missions.constBegin(); it != later._missions.constEnd(); ++it) {
+        auto &missions = _missions[it.key()];
+        for(auto mission = it.value().constBegin(); mission != it.value().constEnd(); ++mission) {
+            missions[mission.key()] = mission.value();
+        }
+    }
+}
+
+QStringList JournalState::settlementKeys(const JournalEvent &event) {
+    auto settlement = event._context._settlement;
+    if(settlement.isEmpty()) {
+        return QStringList();
+    }
+    if(settlement.endsWith("+")) {
+        auto parts = settlement.split(" ");
+        parts.removeLast();
+        settlement = parts.join(" ");
+    }
+    const auto &system = event._context._system;
+    // Planets from log comes with a prefix of the star, get rid of it.
+    auto parts = event._context._body.split(system + " ");
+    if(parts.size() > 1) {
+        parts.removeFirst();
+    }
+    const auto key = SettlementIndex::makeKey(system, parts.join(""), settlement);
+    const auto shortKey = SettlementIndex::makeKey(system, QString(), settlement);
+    return key == shortKey ? QStringList(key) : QStringList({key, shortKey});
+}
+
+QDataStream &operator<<(QDataStream &stream, const JournalState &state) {
+    stream << state._exploredSystems << static_cast<qint32>(state._commanders.size());
+    for(auto it = state._commanders.constBegin(); it != state._commanders.constEnd(); ++it) {
+        stream << it.key() << it.value()._system << it.value()._lastEventDate;
+    }
+    stream << state._settlementScans << static_cast<qint32>(state._missions.size());
+    for(auto it = state._missions.constBegin(); it != state._missions.constEnd(); ++it) {
+        stream << it.key() << static_cast<qint32>(it.value().size());
+        for(auto mission = it.value().constBegin(); mission != it.value().constEnd(); ++mission) {
+            stream << mission.key() << mission.value()._destination << mission.value()._origin
+                   << mission.value()._expiry;
+        }
+    }
+    return stream << state._closedMissions;
+}
+
+QDataStream &operator>>(QDataStream &stream, JournalState &state) {
+    qint32 count;
+    stream >> state._exploredSystems >> count;
+    for(qint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString commander;
+        CommanderInfo info;
+        stream >> commander >> info._system >> info._lastEventDate;
+        state._commanders[commander] = info;
+    }
+    stream >> state._settlementScans >> count;
+    for(qint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString commander;
+        qint32 missionCount;
+        stream >> commander >> missionCount;
+        auto &missions = state._missions[commander];
+        for(qint32 m = 0; m < missionCount && stream.status() == QDataStream::Ok; m++) {
+            qint64 id;
+            JournalMission mission;
+            stream >> id >> mission._destination >> mission._origin >> mission._expiry;
+            missions[id] = mission;
+        }
+    }
+    return stream >> state._closedMissions;
+}
+
+QString JournalIndex::path() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/journal.index";
+}
+
+bool JournalIndex::load() {
+    QFile file(path());
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    quint32 magic, version;
+    qint32 count;
+    stream >> magic >> version >> count;
+    if(magic != JOURNAL_INDEX_MAGIC || version != JOURNAL_INDEX_VERSION || count < 0) {
+        return false;
+    }
+    QMap<QString, FileEntry> files;
+    QStringList order;
+    for(qint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString name;
+        FileEntry entry;
+        stream >> name >> entry._size >> entry._modified >> entry._offset
+               >> entry._context._commander >> entry._context._system >> entry._context._body
+               >> entry._context._settlement >> entry._state;
+        files[name] = entry;
+        order.push_back(name);
+    }
+    if(stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    _files = files;
+    _order = order;
+    return true;
+}
+
+bool JournalIndex::save() const {
+    if(!QDir().mkpath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))) {
+        return false;
+    }
+    QSaveFile file(path());
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << static_cast<quint32>(JOURNAL_INDEX_MAGIC) << static_cast<quint32>(JOURNAL_INDEX_VERSION)
+           << static_cast<qint32>(_order.size());
+    for(const auto &name: _order) {
+        const auto &entry = *_files.constFind(name);
+        stream << name << entry._size << entry._modified << entry._offset
+               << entry._context._commander << entry._context._system << entry._context._body
+               << entry._context._settlement << entry._state;
+    }
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+JournalIndex::FileUpdate JournalIndex::readFile(const QString &path, FileEntry entry) {
+    FileUpdate update;
+    const QFileInfo info(path);
+    if(info.size() < entry._offset) {
+        entry = FileEntry(); // Rewritten, start over.
+    }
+    JournalReader reader(path, entry._context, JournalState::handledEvents());
+    entry._offset = reader.read(entry._offset, update._events);
+    entry._context = reader.context();
+    for(const auto &event: update._events) {
+        entry._state.apply(event);
+    }
+    entry._size = info.size();
+    entry._modified = info.lastModified();
+    update._entry = entry;
+    return update;
+}
+
+JournalEventList JournalIndex::update(const QString &directory) {
+    QDir dir(directory, "Journal.*.log");
+    const auto list = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::Files, QDir::Time | QDir::Reversed);
+
+    // Files that no longer exist are dropped. Changed files are read in parallel, each one
+    // continuing from its own stored context.
+    QMap<QString, FileEntry> files;
+    QStringList order;
+    QStringList changed;
+    QList<QFuture<FileUpdate>> futures;
+    auto pool = TaskScheduler::instance()->pool();
+    for(const auto &info: list) {
+        const auto name = info.fileName();
+        const auto entry = _files.value(name);
+        if(entry._size != info.size() || entry._modified != info.lastModified()) {
+            changed.push_back(name);
+            futures.push_back(QtConcurrent::run(pool, &JournalIndex::readFile, info.absoluteFilePath(), entry));
+        }
+        files[name] = entry;
+        order.push_back(name);
+    }
+
+    JournalEventList newEvents;
+    for(int i = 0; i < futures.size(); i++) {
+        auto &future = futures[i];
+        future.waitForFinished();
+        const auto update = future.result();
+        files[changed[i]] = update._entry;
+        newEvents += update._events;
+    }
+    // Files are in modification order, but a file can be appended to while an older one is
+    // still open, so the combined events are put back in timestamp order. The sort is stable
+    // to keep events with the same timestamp in file order.
+    std::stable_sort(newEvents.begin(), newEvents.end(), [](const JournalEvent &a, const JournalEvent &b) {
+        return a._timestamp < b._timestamp;
+    });
+    _files = files;
+    _order = order;
+    return newEvents;
+}
+
+JournalState JournalIndex::state(const QDateTime &modifiedAfter) const {
+    JournalState state;
+    for(const auto &name: _order) {
+        const auto &entry = *_files.constFind(name);
+        if(modifiedAfter.isNull() || entry._modified >= modifiedAfter) {
+            state.merge(entry._state);
+        }
+    }
+    return state;
+}
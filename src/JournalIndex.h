@@ -0,0 +1,126 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include "CommanderInfo.h"
+#include "JournalReader.h"
+
+class QDataStream;
+
+struct JournalMission {
+    QString _destination;
+    QString _origin;
+    QDateTime _expiry;
+};
+
+// What the route tools need to know from the journals, derived from the events of one or
+// more journal files. States of consecutive files are combined with merge().
+class JournalState {
+public:
+    // The events apply() acts on.
+    static JournalEventMask handledEvents() {
+        return journalEventBit(JournalEventLocation) | journalEventBit(JournalEventFSDJump) |
+               journalEventBit(JournalEventScan) | journalEventBit(JournalEventDatalinkScan) |
+               journalEventBit(JournalEventMissionAccepted) | journalEventBit(JournalEventMissionAbandoned) |
+               journalEventBit(JournalEventMissionFailed) | journalEventBit(JournalEventMissionCompleted);
+    }
+
+    void apply(const JournalEvent &event);
+
+    // Combine with the state of a journal file that was written after the ones in this state.
+    void merge(const JournalState &later);
+
+    // Uppercased names of the systems with scanned bodies, per commander. Every commander with
+    // a known location has an entry.
+    const QMap<QString, QSet<QString>> &exploredSystems() const {
+        return _exploredSystems;
+    }
+
+    const QMap<QString, CommanderInfo> &commanders() const {
+        return _commanders;
+    }
+
+    // Time of the last datalink scan per settlement key (see SettlementIndex::makeKey()). Scans
+    // are recorded both with and without the planet name.
+    const QMap<QString, QMap<QString, QDateTime>> &settlementScans() const {
+        return _settlementScans;
+    }
+
+    // Accepted missions by mission id, including expired ones.
+    const QMap<QString, QMap<qint64, JournalMission>> &missions() const {
+        return _missions;
+    }
+
+    // The settlement keys a datalink scan event is recorded under.
+    static QStringList settlementKeys(const JournalEvent &event);
+
+    friend QDataStream &operator<<(QDataStream &stream, const JournalState &state);
+
+    friend QDataStream &operator>>(QDataStream &stream, JournalState &state);
+
+private:
+    QMap<QString, QSet<QString>> _exploredSystems;
+    QMap<QString, CommanderInfo> _commanders;
+    QMap<QString, QMap<QString, QDateTime>> _settlementScans;
+    QMap<QString, QMap<qint64, JournalMission>> _missions;
+    QMap<QString, QSet<qint64>> _closedMissions;
+};
+
+// Per journal file state, persisted in the cache directory. Files that haven't changed since
+// the last update are not read again, and files that grew are only read from where the
+// previous update stopped.
+class JournalIndex {
+public:
+    JournalIndex() : _files(), _order() { }
+
+    bool load();
+
+    bool save() const;
+
+    // Returns the events read from new and grown files, in timestamp order.
+    JournalEventList update(const QString &directory);
+
+    // Combined state of the journal files last modified at or after modifiedAfter, or of all
+    // of them if it is null.
+    JournalState state(const QDateTime &modifiedAfter = QDateTime()) const;
+
+private:
+    struct FileEntry {
+        FileEntry() : _size(0), _modified(), _offset(0), _context(), _state() { }
+
+        qint64 _size;
+        QDateTime _modified;
+        qint64 _offset;
+        JournalContext _context;
+        JournalState _state;
+    };
+
+    struct FileUpdate {
+        FileEntry _entry;
+        JournalEventList _events;
+    };
+
+    static QString path();
+
+    static FileUpdate readFile(const QString &path, FileEntry entry);
+
+    QMap<QString, FileEntry> _files;
+    QStringList _order; // File names, oldest first
+};
@@ -0,0 +1,153 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "JournalReader.h"
+
+qint64 JournalReader::read(qint64 offset, JournalEventList &events) {
+    QFile file(_path);
+    if(!file.open(QIODevice::ReadOnly) || !file.seek(offset)) {
+        return offset;
+    }
+    const auto data = file.readAll();
+    const auto complete = data.lastIndexOf('\n') + 1;
+    int pos = 0;
+    while(pos < complete) {
+        auto lineEnd = data.indexOf('\n', pos);
+        if(lineEnd > pos) {
+            parseLine(QByteArray::fromRawData(data.constData() + pos, lineEnd - pos), events);
+        }
+        pos = lineEnd + 1;
+    }
+    return offset + complete;
+}
+
+QByteArray JournalReader::eventName(const QByteArray &line) {
+    static const QByteArray key("\"event\"");
+    auto pos = line.indexOf(key);
+    if(pos < 0) {
+        return QByteArray();
+    }
+    pos += key.size();
+    while(pos < line.size() && (line[pos] == ' ' || line[pos] == ':')) {
+        ++pos;
+    }
+    if(pos >= line.size() || line[pos] != '"') {
+        return QByteArray();
+    }
+    const auto end = line.indexOf('"', ++pos);
+    return end < 0 ? QByteArray() : line.mid(pos, end - pos);
+}
+
+void JournalReader::parseLine(const QByteArray &line, JournalEventList &events) {
+    const auto &table = parsedEvents();
+    const auto parsed = table.constFind(eventName(line));
+    if(parsed == table.constEnd() ||
+       (!parsed->_update && !(_events & journalEventBit(static_cast<JournalEventType>(parsed->_type))))) {
+        return;
+    }
+
+    const auto doc = QJsonDocument::fromJson(line);
+    if(!doc.isObject()) {
+        return;
+    }
+    const auto object = doc.object();
+    if(parsed->_update) {
+        parsed->_update(_context, object);
+    }
+    if(parsed->_type != NoEvent) {
+        const auto timestamp = QDateTime::fromString(object.value("timestamp").toString(), Qt::ISODate);
+        addEvent(static_cast<JournalEventType>(parsed->_type), object, timestamp, events);
+    }
+}
+
+const QHash<QByteArray, JournalReader::ParsedEvent> &JournalReader::parsedEvents() {
+    // Events that change the context are always parsed, the rest only when they're in the mask.
+    static const QHash<QByteArray, ParsedEvent> events = {
+            {"LoadGame",           {NoEvent,                      &JournalReader::loadGame}},
+            {"NewCommander",       {NoEvent,                      &JournalReader::newCommander}},
+            {"SupercruiseExit",    {NoEvent,                      &JournalReader::supercruiseExit}},
+            {"SupercruiseEntry",   {NoEvent,                      &JournalReader::supercruiseEntry}},
+            {"ApproachSettlement", {NoEvent,                      &JournalReader::approachSettlement}},
+            {"Docked",             {NoEvent,                      &JournalReader::docked}},
+            {"FSDJump",            {JournalEventFSDJump,          &JournalReader::jump}},
+            {"Location",           {JournalEventLocation,         &JournalReader::jump}},
+            {"Scan",               {JournalEventScan,             nullptr}},
+            {"DatalinkScan",       {JournalEventDatalinkScan,     nullptr}},
+            {"MissionAccepted",    {JournalEventMissionAccepted,  nullptr}},
+            {"MissionAbandoned",   {JournalEventMissionAbandoned, nullptr}},
+            {"MissionFailed",      {JournalEventMissionFailed,    nullptr}},
+            {"MissionCompleted",   {JournalEventMissionCompleted, nullptr}},
+    };
+    return events;
+}
+
+void JournalReader::loadGame(JournalContext &context, const QJsonObject &object) {
+    context._commander = object.value("Commander").toString();
+}
+
+void JournalReader::newCommander(JournalContext &context, const QJsonObject &object) {
+    context._commander = object.value("Name").toString();
+}
+
+void JournalReader::jump(JournalContext &context, const QJsonObject &object) {
+    context._system = object.value("StarSystem").toString();
+    context._body = object.value("BodyType").toString() == "Planet" ? object.value("Body").toString() : QString();
+    context._settlement.clear();
+}
+
+void JournalReader::supercruiseExit(JournalContext &context, const QJsonObject &object) {
+    context._system = object.value("StarSystem").toString();
+    if(object.value("BodyType").toString() == "Station") {
+        context._settlement = object.value("Body").toString();
+    } else {
+        context._body = object.value("Body").toString();
+        context._settlement.clear();
+    }
+}
+
+void JournalReader::supercruiseEntry(JournalContext &context, const QJsonObject &) {
+    context._body.clear();
+    context._settlement.clear();
+}
+
+void JournalReader::approachSettlement(JournalContext &context, const QJsonObject &object) {
+    context._settlement = object.value("Name").toString();
+}
+
+void JournalReader::docked(JournalContext &context, const QJsonObject &object) {
+    context._settlement = object.value("StationName").toString();
+}
+
+void JournalReader::addEvent(JournalEventType type, const QJsonObject &object, const QDateTime &timestamp,
+                             JournalEventList &events) const {
+    if(!(_events & journalEventBit(type))) {
+        return;
+    }
+    JournalEvent event;
+    event._type = type;
+    event._timestamp = timestamp;
+    event._context = _context;
+    if(object.contains("MissionID")) {
+        event._missionId = static_cast<qint64>(object.value("MissionID").toDouble());
+        event._destination = object.value("DestinationSystem").toString();
+        event._expiry = QDateTime::fromString(object.value("Expiry").toString(), Qt::ISODate);
+    }
+    events.push_back(event);
+}
@@ -0,0 +1,132 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class QJsonObject;
+
+// The journal events the route tools act on.
+enum JournalEventType {
+    JournalEventLocation,
+    JournalEventFSDJump,
+    JournalEventScan,
+    JournalEventDatalinkScan,
+    JournalEventMissionAccepted,
+    JournalEventMissionAbandoned,
+    JournalEventMissionFailed,
+    JournalEventMissionCompleted,
+    JournalEventTypeCount
+};
+
+typedef quint32 JournalEventMask;
+
+inline JournalEventMask journalEventBit(JournalEventType type) {
+    return 1u << type;
+}
+
+const JournalEventMask JournalEventMaskAll = (1u << JournalEventTypeCount) - 1;
+
+// Where the commander was when an event was logged. Journal events only carry part of this,
+// the rest is tracked from earlier events in the same file.
+struct JournalContext {
+    QString _commander;
+    QString _system;
+    QString _body;
+    QString _settlement;
+};
+
+struct JournalEvent {
+    JournalEvent()
+            : _type(JournalEventLocation), _timestamp(), _context(), _missionId(0), _destination(), _expiry() { }
+
+    JournalEventType _type;
+    QDateTime _timestamp;
+    JournalContext _context;
+
+    // Mission events only.
+    qint64 _missionId;
+    QString _destination;
+    QDateTime _expiry;
+};
+
+typedef QVector<JournalEvent> JournalEventList;
+
+// Reads a journal file from a byte offset. Only complete lines are consumed, so a file that is
+// still being written can be read again later from the returned offset, with the context the
+// previous read ended with.
+//
+// Only events in the mask are returned. The event name is picked out of the raw line first and
+// lines with events that neither are wanted nor change the context are skipped without being
+// parsed, which is most of them.
+class JournalReader {
+public:
+    explicit JournalReader(const QString &path, const JournalContext &context = JournalContext(),
+                           JournalEventMask events = JournalEventMaskAll)
+            : _path(path), _context(context), _events(events) { }
+
+    // Appends the events found after offset and returns the offset to continue from.
+    qint64 read(qint64 offset, JournalEventList &events);
+
+    const JournalContext &context() const {
+        return _context;
+    }
+
+private:
+    typedef void (*ContextUpdate)(JournalContext &context, const QJsonObject &object);
+
+    // For events that only change the context.
+    static const int NoEvent = -1;
+
+    struct ParsedEvent {
+        int _type; // JournalEventType or NoEvent
+        ContextUpdate _update; // How the event changes the context, if it does
+    };
+
+    // Every event the reader looks at, by name. Both the line prefilter and the parsing are
+    // driven by this table.
+    static const QHash<QByteArray, ParsedEvent> &parsedEvents();
+
+    static void loadGame(JournalContext &context, const QJsonObject &object);
+
+    static void newCommander(JournalContext &context, const QJsonObject &object);
+
+    static void jump(JournalContext &context, const QJsonObject &object);
+
+    static void supercruiseExit(JournalContext &context, const QJsonObject &object);
+
+    static void supercruiseEntry(JournalContext &context, const QJsonObject &object);
+
+    static void approachSettlement(JournalContext &context, const QJsonObject &object);
+
+    static void docked(JournalContext &context, const QJsonObject &object);
+
+    // The value of the "event" key, or an empty array if the line doesn't have one.
+    static QByteArray eventName(const QByteArray &line);
+
+    void parseLine(const QByteArray &line, JournalEventList &events);
+
+    void addEvent(JournalEventType type, const QJsonObject &object, const QDateTime &timestamp,
+                  JournalEventList &events) const;
+
+    QString _path;
+    JournalContext _context;
+    JournalEventMask _events;
+};
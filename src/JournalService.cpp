@@ -0,0 +1,135 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QtConcurrent>
+#include "JournalService.h"
+#include "TaskScheduler.h"
+
+// The index is written at most this often while the game is running, and on exit.
+#define JOURNAL_SAVE_DELAY_MS 60000
+
+JournalService *JournalService::instance() {
+    // Parented to the application so the watcher is torn down before QCoreApplication is.
+    static JournalService *service = new JournalService(QCoreApplication::instance());
+    return service;
+}
+
+JournalService::JournalService(QObject *parent)
+        : QObject(parent), _index(), _directory(), _watcher(new QFileSystemWatcher(this)), _updateWatcher(),
+          _saveTimer(), _loaded(false), _updatePending(false) {
+    _saveTimer.setSingleShot(true);
+    _saveTimer.setInterval(JOURNAL_SAVE_DELAY_MS);
+    connect(&_saveTimer, &QTimer::timeout, this, &JournalService::saveInBackground);
+    connect(&_updateWatcher, &QFutureWatcher<IndexUpdate>::finished, this, &JournalService::updateFinished);
+    connect(_watcher, &QFileSystemWatcher::directoryChanged, this, &JournalService::update);
+    connect(_watcher, &QFileSystemWatcher::fileChanged, this, &JournalService::update);
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &JournalService::save);
+}
+
+void JournalService::watchDirectory(const QString &directory) {
+    const auto watched = _watcher->directories() + _watcher->files();
+    if(!watched.isEmpty()) {
+        _watcher->removePaths(watched);
+    }
+    _directory = directory;
+    _loaded = false;
+    _index = JournalIndex();
+    if(QDir(_directory).exists()) {
+        _watcher->addPath(_directory);
+    }
+    update();
+}
+
+void JournalService::update() {
+    if(_directory.isEmpty()) {
+        return;
+    }
+    if(_updateWatcher.isRunning()) {
+        _updatePending = true;
+        return;
+    }
+    // The update works on a copy, so state() can be used while it runs.
+    auto index = _index;
+    const auto directory = _directory;
+    const bool load = !_loaded;
+    _updateWatcher.setFuture(QtConcurrent::run(TaskScheduler::instance()->pool(), [index, directory, load]() mutable {
+        if(load) {
+            index.load();
+        }
+        IndexUpdate update;
+        update._events = index.update(directory);
+        if(load) {
+            index.save();
+        }
+        update._index = index;
+        return update;
+    }));
+}
+
+void JournalService::updateFinished() {
+    const auto update = _updateWatcher.result();
+    _index = update._index;
+    watchNewestFile();
+    if(!_loaded) {
+        _loaded = true;
+        emit loaded();
+        emit stateChanged();
+    } else if(!update._events.isEmpty()) {
+        emit eventsReceived(update._events);
+        emit stateChanged();
+        if(!_saveTimer.isActive()) {
+            _saveTimer.start();
+        }
+    }
+    if(_updatePending) {
+        _updatePending = false;
+        this->update();
+    }
+}
+
+void JournalService::save() {
+    _saveTimer.stop();
+    if(_loaded) {
+        _index.save();
+    }
+}
+
+void JournalService::saveInBackground() {
+    if(_loaded) {
+        const auto index = _index;
+        QtConcurrent::run(TaskScheduler::instance()->pool(), [index]() {
+            index.save();
+        });
+    }
+}
+
+void JournalService::watchNewestFile() {
+    // Only the file the game is writing to changes, the directory changes when a new one is created.
+    const auto files = QDir(_directory, "Journal.*.log").entryInfoList(QDir::Files, QDir::Time);
+    const auto newest = files.isEmpty() ? QString() : files.first().absoluteFilePath();
+    if(!_watcher->files().contains(newest)) {
+        if(!_watcher->files().isEmpty()) {
+            _watcher->removePaths(_watcher->files());
+        }
+        if(!newest.isEmpty()) {
+            _watcher->addPath(newest);
+        }
+    }
+}
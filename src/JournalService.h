@@ -0,0 +1,89 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QTimer>
+#include "JournalIndex.h"
+
+class QFileSystemWatcher;
+
+// Process wide owner of the journal index. The journal directory is watched once and every
+// window reads the combined state from here, or subscribes to eventsReceived() for events as
+// they are written, instead of rescanning the journals itself.
+class JournalService : public QObject {
+Q_OBJECT
+
+public:
+    static JournalService *instance();
+
+    // Loads the persisted index, brings it up to date and starts watching the directory. This
+    // happens in the background, loaded() is emitted when done. Events already in the journals
+    // are not emitted, read them from state().
+    void watchDirectory(const QString &directory);
+
+    bool isLoaded() const {
+        return _loaded;
+    }
+
+    // See JournalIndex::state().
+    JournalState state(const QDateTime &modifiedAfter = QDateTime()) const {
+        return _index.state(modifiedAfter);
+    }
+
+public slots:
+
+    // Reads whatever was written since the last update in the background and emits the new
+    // events once done.
+    void update();
+
+    void save();
+
+signals:
+
+    void loaded();
+
+    // The events read by one update, in timestamp order.
+    void eventsReceived(const JournalEventList &events);
+
+    // Emitted after an update that read new events.
+    void stateChanged();
+
+private:
+    struct IndexUpdate {
+        JournalIndex _index;
+        JournalEventList _events;
+    };
+
+    explicit JournalService(QObject *parent);
+
+    void updateFinished();
+
+    void saveInBackground();
+
+    void watchNewestFile();
+
+    JournalIndex _index;
+    QString _directory;
+    QFileSystemWatcher *_watcher;
+    QFutureWatcher<IndexUpdate> _updateWatcher;
+    QTimer _saveTimer;
+    bool _loaded;
+    bool _updatePending;
+};
@@ -16,23 +16,25 @@
 //
 
 #include <QDebug>
+#include <QDir>
 #include <QCheckBox>
 #include <QCompleter>
 #include <QListView>
 #include "MainWindow.h"
-#include "QCompressor.h"
 #include "MissionRouter.h"
 #include "ValueRouter.h"
+#include "JournalService.h"
+#include "CoordinateService.h"
 
 MainWindow::MainWindow(QWidget *parent)
         : AbstractBaseWindow(parent, new AStarRouter(), new SystemList()),
-          _journalWatcher(new JournalWatcher(this)), _settlementDates() {
+          _matchingSettlementCount(0), _visitedSettlements(), _settlementIndex(), _matchingSettlements() {
     buildLookupMap();
     loadCompressedData();
     _ui->centralWidget->setEnabled(false);
     _ui->menuBar->setEnabled(false);
-    connect(_journalWatcher, SIGNAL(onEvent(const JournalFile &, const Event &)),
-            this, SLOT(handleEvent( const JournalFile &, const Event &)));
+    connect(JournalService::instance(), &JournalService::loaded, this, &MainWindow::journalsLoaded);
+    connect(JournalService::instance(), &JournalService::eventsReceived, this, &MainWindow::handleEvents);
     _ui->filterCommander->setInsertPolicy(QComboBox::InsertAlphabetically);
     _ui->distanceSlider->setMaximum(10000);
     _ui->distanceSlider->setValue(10000);
@@ -40,7 +42,6 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow() {
     delete _router;
-    delete _journalWatcher;
     delete _systemResolver;
 }
 
@@ -89,8 +90,8 @@ void MainWindow::updateFilters() {
     }
 
     auto selectedCommander = _ui->filterCommander->currentText();
-    auto commanders = _settlementDates.keys();
-    auto visitedSettlements = QMap<QString, QDateTime>();
+    auto commanders = _visitedSettlements.keys();
+    const VisitedSettlements *visitedSettlements = nullptr;
     if(commanders.size()) {
         commanders.sort();
         for(auto commanderName: commanders) {
@@ -100,8 +101,8 @@ void MainWindow::updateFilters() {
         }
         if(!selectedCommander.isEmpty()) {
             _ui->filterCommander->setCurrentText(selectedCommander);
-            if(_ui->filterVisited->isChecked()) {
-                visitedSettlements = _settlementDates[selectedCommander];
+            if(_ui->filterVisited->isChecked() && _visitedSettlements.contains(selectedCommander)) {
+                visitedSettlements = &*_visitedSettlements.constFind(selectedCommander);
             }
         }
     }
@@ -134,106 +135,89 @@ void MainWindow::updateFilters() {
     }
 
 
-    int32 matches = 0;
-    _filteredSystems.clear();
-    auto filteredDate = QDateTime().currentDateTime().addDays(-14); // two weeks.
-
-    for(const auto &system : *_systems) {
-        PlanetList matchingPlanets;
-        for(const auto &planet: system.planets()) {
-            if(_ui->unknownDistance->isChecked() && !planet.distance()) {
-                continue;
-            }
-            if(distanceFilterChecked && maxDistance && planet.distance() && planet.distance() > maxDistance) {
-                continue;
-            }
-            SettlementList matchingSettlements;
-            for(auto settlement: planet.settlements()) {
-                auto settlementKey = makeSettlementKey(system, planet, settlement);
-                QDateTime scanDate;
-                if(visitedSettlements.contains(settlementKey)) {
-                    scanDate = visitedSettlements[settlementKey];
-                } else {
-                    settlementKey = makeSettlementKey(system, Planet(), settlement);
-                    if(visitedSettlements.contains(settlementKey)) {
-                        scanDate = visitedSettlements[settlementKey];
-                    }
-                }
-                if(scanDate > filteredDate) {
-                    continue;
-                }
-                if((settlement.flags() & settlementFlags) != settlementFlags) {
-                    continue;
-                }
-                if((settlementSizes & settlement.size()) != settlement.size()) {
-                    continue;
-                }
-                if((threatFilter & settlement.threatLevel()) != settlement.threatLevel()) {
-                    continue;
-                }
-                if(jumpsExcluded &&
-                   (settlement.flags() & SettlementFlagsJumpClimbRequired) == SettlementFlagsJumpClimbRequired) {
-                    continue;
-                }
-                matchingSettlements.push_back(settlement);
-                ++matches;
-            }
-            if(matchingSettlements.size()) {
-                matchingPlanets.push_back(Planet(planet.name(), planet.distance(), matchingSettlements));
-            }
-        }
-        if(matchingPlanets.size()) {
-            _filteredSystems.push_back(System(system.name(), matchingPlanets, system.position()));
-        }
+    SettlementFilter filter;
+    filter.requireFlags(settlementFlags);
+    if(jumpsExcluded) {
+        filter.excludeFlags(SettlementFlagsJumpClimbRequired);
+    }
+    filter.allowSizes(settlementSizes);
+    filter.allowThreatLevels(threatFilter);
+    if(_ui->unknownDistance->isChecked()) {
+        filter.excludeUnknownDistance();
     }
-    auto numSystems = (int) _filteredSystems.size();
+    if(distanceFilterChecked) {
+        filter.setMaxDistance(maxDistance);
+    }
+    if(visitedSettlements) {
+        auto filteredDate = QDateTime().currentDateTime().addDays(-14); // two weeks.
+        filter.setExcludeVisited(visitedSettlements, filteredDate);
+    }
+
+    _matchingSettlements = _settlementIndex.filter(filter);
+    auto numSystems = _settlementIndex.countSystems(_matchingSettlements);
     updateSliderParams(numSystems);
 
-    _matchingSettlementCount = matches;
+    _matchingSettlementCount = _matchingSettlements.size();
     _ui->statusBar->showMessage(QString("Filter matches %1 settlements in %2 systems.").arg(_matchingSettlementCount)
-                                                                                       .arg(_filteredSystems.size()));
+                                                                                       .arg(numSystems));
 }
 
-void MainWindow::loadCompressedData() {
-    showMessage("Loading known systems...", 0);
-    QFile file(":/systems.txt.gz");
-    if(!file.open(QIODevice::ReadOnly)) { return; }
-    auto compressor = new QCompressor(file.readAll());
-
-    QFile file2(":/valuable-systems.csv.gz");
-    if(!file2.open(QIODevice::ReadOnly)) { return; }
-    auto compressor2 = new QCompressor(file2.readAll());
+bool MainWindow::hasFilteredSystems() const {
+    return _matchingSettlements.size() > 0;
+}
 
+TSPWorker *MainWindow::createWorker(System *originSystem, int routeSize) {
+    auto worker = new TSPWorker(SystemList(), originSystem, routeSize);
+    worker->setSettlementMatches(_settlementIndex, _matchingSettlements);
+    return worker;
+}
 
+void MainWindow::loadCompressedData() {
+    showMessage("Loading known systems...", 0);
     SystemLoader *loader = new SystemLoader(_router);
+    loader->setCachedSystems(CoordinateService::instance()->cachedSystems());
 
-    connect(compressor, &QThread::finished, compressor, &QObject::deleteLater);
-    connect(compressor2, &QThread::finished, compressor2, &QObject::deleteLater);
-    connect(loader, &QThread::finished, compressor, &QObject::deleteLater);
+    connect(loader, &WorkerTask::finished, loader, &QObject::deleteLater);
     connect(loader, SIGNAL(progress(int)), this, SLOT(systemLoadProgress(int)));
     connect(loader, SIGNAL(sortingSystems()), this, SLOT(systemSortingProgress()));
-    connect(loader, SIGNAL(systemsLoaded(const SystemList &)), this, SLOT(systemsLoaded(const SystemList &)));
-    connect(compressor, SIGNAL(complete(const QByteArray &)), loader, SLOT(dataDecompressed(const QByteArray &)));
-    connect(compressor2, SIGNAL(complete(const QByteArray &)), loader, SLOT(valuableSystemDataDecompressed(const QByteArray &)));
-
-    compressor->start();
-    compressor2->start();
+    connect(loader, SIGNAL(systemsLoaded(const SystemList &, const SettlementIndex &)),
+            this, SLOT(systemsLoaded(const SystemList &, const SettlementIndex &)));
+    loader->start();
 }
 
-void MainWindow::systemsLoaded(const SystemList &systems) {
+void MainWindow::systemsLoaded(const SystemList &systems, const SettlementIndex &settlementIndex) {
     _systems->clear();
     _systems->append(systems);
+    _settlementIndex = settlementIndex;
+    _settlementIndex.setSystems(_systems);
     _ui->systemCountSlider->setMinimum(1);
     _ui->systemCountSlider->setSingleStep(1);
     updateSliderParams(_systems->size());
-    updateFilters();
     _ui->centralWidget->setEnabled(true);
     _ui->menuBar->setEnabled(true);
-    // Start monitoring.  Things changed in the last 16 days  - we need 14 days for expire.
-    auto newerThanDate = QDateTime::currentDateTime().addDays(-16);
-    _loading = true;
-    _journalWatcher->watchDirectory(journalDirectory(), newerThanDate);
-    _loading = false;
+    updateFilters();
+    // Start monitoring. The journals are indexed in the background, see journalsLoaded().
+    JournalService::instance()->watchDirectory(journalDirectory());
+}
+
+void MainWindow::journalsLoaded() {
+    // Things changed in the last 16 days  - we need 14 days for expire.
+    const auto state = JournalService::instance()->state(QDateTime::currentDateTime().addDays(-16));
+    _visitedSettlements.clear();
+    const auto &settlementScans = state.settlementScans();
+    for(auto commander = settlementScans.constBegin(); commander != settlementScans.constEnd(); ++commander) {
+        auto &visited = _visitedSettlements[commander.key()];
+        for(auto scan = commander.value().constBegin(); scan != commander.value().constEnd(); ++scan) {
+            _settlementIndex.recordScan(scan.key(), scan.value(), visited);
+        }
+    }
+    _commanderInformation = state.commanders();
+    for(const auto &commander: _commanderInformation.keys()) {
+        if(_ui->filterCommander->findText(commander) < 0) {
+            _ui->filterCommander->addItem(commander);
+        }
+    }
+    updateFilters();
     updateCommanderAndSystem();
 }
 
@@ -261,63 +245,39 @@ int MainWindow::distanceSliderValue() const {
     return value;
 }
 
-void MainWindow::handleEvent(const JournalFile &journal, const Event &event) {
-    //sqDebug() << "Got event"<<event.obj();
-    const QString &commander = journal.commander();
-    if(commander.isEmpty()) {
-        return;
-    }
-    switch(event.type()) {
-    case EventTypeDatalinkScan: {
-        auto settlementName = journal.settlement();
-        if(settlementName.isEmpty()) {
-            return;
+void MainWindow::handleEvents(const JournalEventList &events) {
+    bool scansChanged = false;
+    bool locationChanged = false;
+    for(const auto &event: events) {
+        const QString &commander = event._context._commander;
+        if(commander.isEmpty()) {
+            continue;
         }
-        if(settlementName.endsWith("+")) {
-            auto parts = settlementName.split(" ");
-            parts.removeLast();
-            settlementName = parts.join(" ");
-        }
-
-        auto settlementKey = makeSettlementKey(journal.system(), journal.body(), settlementName);
-        auto shortSettlementKey = makeSettlementKey(journal.system(), "", settlementName);
-        updateSettlementScanDate(commander, settlementKey, event.timestamp());
-        if(settlementKey != shortSettlementKey) {
-            updateSettlementScanDate(commander, shortSettlementKey, event.timestamp());
+        switch(event._type) {
+        case JournalEventDatalinkScan:
+            for(const auto &key: JournalState::settlementKeys(event)) {
+                updateSettlementScanDate(commander, key, event._timestamp);
+                scansChanged = true;
+            }
+            break;
+        case JournalEventLocation:
+        case JournalEventFSDJump:
+            locationChanged |= updateCommanderInfo(event);
+            break;
+        default:
+            break; // Be quiet
         }
-        updateFilters();
-        break;
     }
-    case EventTypeLocation:
-    case EventTypeFSDJump:
-        if(updateCommanderInfo(journal, event, commander)  && !_loading) {
-            updateCommanderAndSystem();
-        }
-        break;
-    default:
-        break; // Be quiet
+    if(locationChanged) {
+        updateCommanderAndSystem();
     }
-}
-
-void MainWindow::updateSettlementScanDate(const QString &commander, const QString &key, const QDateTime &timestamp) {
-    if(_settlementDates[commander][key] < timestamp) {
-        _settlementDates[commander][key] = timestamp;
+    if(scansChanged) {
+        scheduleFilterUpdate();
     }
 }
 
-const QString MainWindow::makeSettlementKey(const System &system, const Planet &planet,
-                                            const Settlement &settlement) const {
-    return QString("%1:%2:%3").arg(system.name()).arg(planet.name()).arg(settlement.name()).toLower();
-}
-
-const QString MainWindow::makeSettlementKey(const QString &system, const QString &planet,
-                                            const QString &settlement) const {
-    // Planets from log comes with a prefix of the star, get rid of it.
-    auto parts = planet.split(system + " ");
-    if(parts.size() > 1) {
-        parts.removeFirst();
-    }
-    return QString("%1:%2:%3").arg(system).arg(parts.join("")).arg(settlement).toLower();
+void MainWindow::updateSettlementScanDate(const QString &commander, const QString &key, const QDateTime &timestamp) {
+    _settlementIndex.recordScan(key, timestamp, _visitedSettlements[commander]);
 }
 
 void MainWindow::systemLoadProgress(int progress) {
@@ -329,9 +289,6 @@ void MainWindow::systemSortingProgress() {
 }
 
 void MainWindow::updateSystemForCommander(const QString &commander) {
-    if(_loading) {
-        return;
-    }
     _ui->commanderFilterGroup->setEnabled(true);
 
     CommanderInfo info = _commanderInformation[commander];
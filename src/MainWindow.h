@@ -23,6 +23,8 @@
 #include "SystemEntryCoordinateResolver.h"
 #include "ui_MainWindow.h"
 #include "AbstractBaseWindow.h"
+#include "SettlementIndex.h"
+#include "JournalReader.h"
 
 class RouteResult;
 
@@ -40,14 +42,16 @@ public:
     static const QString journalDirectory();
 
 protected slots:
-    void systemsLoaded(const SystemList &systems);
+    void systemsLoaded(const SystemList &systems, const SettlementIndex &settlementIndex);
 
 
     virtual void routeCalculated(const RouteResult &route);
 
     virtual void updateFilters();
 
-    void handleEvent(const JournalFile &journal, const Event &event);
+    void journalsLoaded();
+
+    void handleEvents(const JournalEventList &events);
 
     void systemLoadProgress(int progress);
     void systemSortingProgress();
@@ -55,6 +59,11 @@ protected slots:
     void openMissionTool();
     void openExplorationTool();
 
+protected:
+    virtual bool hasFilteredSystems() const override;
+
+    virtual TSPWorker *createWorker(System *originSystem, int routeSize) override;
+
 private:
 
     void buildLookupMap();
@@ -63,22 +72,18 @@ private:
 
     void updateSliderParams(int size);
 
-    const QString makeSettlementKey(const System &system, const Planet &planet, const Settlement &settlement) const;
-
-    const QString makeSettlementKey(const QString &system, const QString &planet, const QString &settlement) const;
+    void updateSystemForCommander(const QString &commander);
 
     void updateSettlementScanDate(const QString &commander, const QString &key, const QDateTime &timestamp);
 
-    void updateSystemForCommander(const QString &commander);
-
     int distanceSliderValue() const;
 
     QMap<QString, SettlementFlags> _flagsLookup;
 
     int32         _matchingSettlementCount;
 
-    JournalWatcher *_journalWatcher;
-    QMap<QString,QMap<QString,QDateTime>> _settlementDates;
+    QMap<QString, VisitedSettlements> _visitedSettlements;
 
-    bool _loading;
+    SettlementIndex _settlementIndex;
+    QVector<int> _matchingSettlements;
 };
@@ -2,12 +2,15 @@
 #include <QCompleter>
 #include "MissionRouter.h"
 #include "RouteViewer.h"
-#include "EDSMQueryExecutor.h"
+#include "CoordinateService.h"
+#include "JournalService.h"
 
 MissionRouter::MissionRouter(QWidget *parent, AStarRouter *router, const SystemList &systems)
         : QMainWindow(parent), _ui(new Ui::MissionRouter), _scanner(this), _router(router), _systems(systems),
-          _currentModel(nullptr), _routingPending(false), _customStops(), _systemResolver(nullptr) {
+          _currentModel(nullptr), _pendingDestinations(), _customStops(), _systemResolver(nullptr) {
     _ui->setupUi(this);
+    // Also emitted once the journals are first loaded, and after the update a scan starts.
+    connect(JournalService::instance(), &JournalService::stateChanged, this, &MissionRouter::refreshMissions);
     refreshMissions();
     auto table = _ui->tableView;
     table->setSelectionBehavior(QTableView::SelectRows);
@@ -19,6 +22,10 @@ MissionRouter::MissionRouter(QWidget *parent, AStarRouter *router, const SystemL
     connect(_systemResolver, SIGNAL(systemLookupInitiated(const QString &)), this, SLOT(onSystemLookupInitiated(const QString &)));
     connect(_systemResolver, SIGNAL(systemLookupFailed(const QString &)), this, SLOT(onSystemCoordinatesRequestFailed(const QString &)));
     connect(_systemResolver, SIGNAL(systemLookupCompleted(const System &)), this, SLOT(onSystemCoordinatesReceived(const System &)));
+
+    auto coordinates = CoordinateService::instance();
+    connect(coordinates, &CoordinateService::coordinatesReceived, this, &MissionRouter::onDestinationCoordinatesReceived);
+    connect(coordinates, &CoordinateService::coordinateRequestFailed, this, &MissionRouter::onDestinationLookupFailed);
 }
 
 void MissionRouter::copySelectedItem() {
@@ -95,37 +102,47 @@ void MissionRouter::optimizeRoute() {
     auto       cmdr       = _ui->commanders->currentText();
     auto       systemName = _scanner.commanderSystem(cmdr);
     System     *originSystem(nullptr);
+    QSet<QString> visitedSystems;
+    QStringList missingSystems;
     if(!systemName.isEmpty()) {
         originSystem = _router->findSystemByName(systemName);
         if(!originSystem) {
-            // Need to fetch coordinates for origin.
-            _systemResolver->resolve(systemName);
-            _routingPending = true;
-            return;
+            missingSystems.push_back(systemName);
+        } else {
+            CoordinateService::instance()->markUsed(originSystem->name());
         }
     }
-    QSet<QString> visitedSystems;
     visitedSystems.insert(systemName);
-    for(auto system: _currentModel->missions()) {
+    for(const auto &system: _currentModel->missions()) {
         if(visitedSystems.contains(system._destination)) {
             continue;
         }
         visitedSystems.insert(system._destination);
         auto missionSystem = _router->findSystemByName(system._destination);
         if(!missionSystem) {
-            _systemResolver->resolve(system._destination);
-            _routingPending = true;
-            return;
+            missingSystems.push_back(system._destination);
+            continue;
         }
+        CoordinateService::instance()->markUsed(missionSystem->name());
         routeSystems.push_back(System(missionSystem->name(), PlanetList(), missionSystem->position()));
     }
+    if(!missingSystems.isEmpty()) {
+        // Look them all up at once and start over when the last one is in.
+        for(const auto &missing: missingSystems) {
+            _pendingDestinations.insert(missing.toLower());
+        }
+        showMessage(QString("Looking up coordinates for %1 systems...").arg(missingSystems.size()), 0);
+        _ui->centralwidget->setEnabled(false);
+        CoordinateService::instance()->lookup(missingSystems);
+        return;
+    }
     routeSystems.push_back(*originSystem);
 
     const auto tspWorker = new TSPWorker(routeSystems, originSystem, routeSystems.size());
     tspWorker->setSystemsOnly(true);
     TSPWorker *workerThread(tspWorker);
     // workerThread->setRouter(_router);
-    connect(workerThread, &QThread::finished, workerThread, &QObject::deleteLater);
+    connect(workerThread, &WorkerTask::finished, workerThread, &QObject::deleteLater);
     connect(workerThread, &TSPWorker::taskCompleted, this, &MissionRouter::routeCalculated);
     workerThread->start();
     //_ui->centralWidget->setEnabled(false);
@@ -145,27 +162,43 @@ void MissionRouter::routeCalculated(const RouteResult &route) {
 
 void MissionRouter::onSystemCoordinatesRequestFailed(const QString &systemName) {
     showMessage(QString("Coordinate lookup failed for %1").arg(systemName));
-    _routingPending = false;
-    _ui->centralwidget->setEnabled(_systemResolver->isComplete());
+    _ui->centralwidget->setEnabled(_systemResolver->isComplete() && _pendingDestinations.isEmpty());
 }
 
 void MissionRouter::onSystemCoordinatesReceived(const System &system) {
     showMessage(QString("Found coordinates for system: %1").arg(system.name()), 4000);
-    if(!_routingPending) {
-        _customStops << system.name();
-        updateMissionTable();
-    }
+    _customStops << system.name();
+    updateMissionTable();
     if(_systemResolver->isComplete()) {
-        _ui->centralwidget->setEnabled(true);
-
-        if(_routingPending) {
-            _routingPending = false;
-            optimizeRoute();
-        }
+        _ui->centralwidget->setEnabled(_pendingDestinations.isEmpty());
         _ui->customSystem->setText("");
     }
 }
 
+void MissionRouter::onDestinationCoordinatesReceived(const System &system) {
+    if(!_pendingDestinations.remove(system.name().toLower())) {
+        return;
+    }
+    if(!_router->findSystemByName(system.name())) {
+        _router->insertSystem(system);
+    }
+    if(_pendingDestinations.isEmpty()) {
+        _ui->centralwidget->setEnabled(_systemResolver->isComplete());
+        optimizeRoute();
+    }
+}
+
+void MissionRouter::onDestinationLookupFailed(const QString &systemName) {
+    if(!_pendingDestinations.remove(systemName.toLower())) {
+        return;
+    }
+    // The route can't be made without it, so the lookups still out are ignored.
+    _pendingDestinations.clear();
+    showMessage(QString("Coordinate lookup failed for %1").arg(systemName));
+    _ui->centralwidget->setEnabled(_systemResolver->isComplete());
+    _ui->optimizeButton->setEnabled(true);
+}
+
 
 void MissionRouter::showMessage(const QString &message, int timeout) {
     _ui->statusbar->showMessage(message, timeout);
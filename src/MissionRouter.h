@@ -47,6 +47,10 @@ private slots:
 
     void onSystemCoordinatesRequestFailed(const QString &systemName);
 
+    void onDestinationCoordinatesReceived(const System &system);
+
+    void onDestinationLookupFailed(const QString &systemName);
+
     void copySelectedItem();
 
 private:
@@ -55,7 +59,7 @@ private:
     AStarRouter       *_router;
     const SystemList  &_systems;
     MissionTableModel *_currentModel;
-    bool _routingPending;
+    QSet<QString>     _pendingDestinations; // Lowercase names of the route systems being looked up
     QSet<QString>     _customStops;
     SystemEntryCoordinateResolver *_systemResolver;
 
@@ -14,10 +14,7 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-#include <deps/EDJournalQT/src/JournalFile.h>
-#include <QDebug>
-#include <QDirIterator>
-#include "MainWindow.h"
+#include "JournalService.h"
 #include "MissionScanner.h"
 
 MissionScanner::MissionScanner(QObject *parent)
@@ -26,47 +23,26 @@ MissionScanner::MissionScanner(QObject *parent)
 
 void MissionScanner::scanJournals() {
     _commanderMissions.clear();
-    QDir          dir(MainWindow::journalDirectory(), "Journal.*.log");
-    QFileInfoList list        = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::Files, QDir::Time | QDir::Reversed);
-    auto          monitorDate = QDateTime::currentDateTime().addDays(-30); // Missions last at most a month.
+    _commanderLastSystem.clear();
+    // The update runs in the background. If it finds new events, JournalService emits
+    // stateChanged() and the owner scans again.
+    auto journals = JournalService::instance();
+    journals->update();
 
-    for(auto entry: list) {
-        if(entry.lastModified() < monitorDate) {
-            continue;
+    // Missions last at most a month.
+    const auto state = journals->state(QDateTime::currentDateTime().addDays(-30));
+    const auto now = QDateTime::currentDateTimeUtc();
+    const auto &missions = state.missions();
+    for(auto commander = missions.constBegin(); commander != missions.constEnd(); ++commander) {
+        for(auto mission = commander.value().constBegin(); mission != commander.value().constEnd(); ++mission) {
+            if(mission.value()._expiry >= now) {
+                _commanderMissions[commander.key()][mission.key()] = Mission(mission.value()._destination,
+                                                                             mission.value()._origin);
+            }
         }
-        auto file = entry.absoluteFilePath();
-        JournalFile journalFile(file);
-        connect(&journalFile, SIGNAL(onEvent(const JournalFile &, const Event &)), this, SLOT(handleEvent(const JournalFile &, const Event &)));
-        journalFile.parse();
     }
-}
-
-void MissionScanner::handleEvent(const JournalFile &file, const Event &ev) {
-    QDateTime now = QDateTime::currentDateTimeUtc();
-    switch(ev.type()) {
-        case EventTypeMissionAccepted:
-//            qDebug() << ev.obj();
-            if(ev.date("Expiry") >= now) {
-                auto destination = ev.string("DestinationSystem");
-                if(!destination.isEmpty() && file.system() != destination) {
-                    auto mission = Mission(destination, file.system());
-                    _commanderMissions[file.commander()][ev.integer("MissionID")] = mission;
-                }
-            }
-            break;
-        case EventTypeMissionAbandoned:
-        case EventTypeMissionFailed:
-        case EventTypeMissionCompleted:
-            _commanderMissions[file.commander()].remove(ev.integer("MissionID"));
-            break;
-        case EventTypeFSDJump:
-        case EventTypeLocation:
-      //      qDebug() << file.commander() << " in "<<file.system();
-            _commanderLastSystem[file.commander()] = file.system();
-            break;
-        default:
-            break;
+    const auto &commanders = state.commanders();
+    for(auto it = commanders.constBegin(); it != commanders.constEnd(); ++it) {
+        _commanderLastSystem[it.key()] = it.value()._system;
     }
 }
-
-
@@ -20,10 +20,6 @@
 #include <QObject>
 #include <QMap>
 
-class JournalFile;
-
-class Event;
-
 struct Mission {
     Mission(const QString &destination, const QString &origin)
             : _destination(destination), _origin(origin) { }
@@ -51,12 +47,8 @@ public:
 
     void scanJournals();
 
-private slots:
-
-    void handleEvent(const JournalFile &file, const Event &ev);
-
 private:
-    QMap<QString, QMap<int, Mission>> _commanderMissions;
+    QMap<QString, QMap<qint64, Mission>> _commanderMissions;
     QMap<QString, QString>            _commanderLastSystem;
 };
 
@@ -0,0 +1,118 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <QCoreApplication>
+#include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
+#include <QStandardPaths>
+#include "NetworkService.h"
+
+// Same as the per host connection limit of QNetworkAccessManager.
+#define NETWORK_MAX_RUNNING_REQUESTS 6
+
+NetworkService *NetworkService::instance() {
+    static NetworkService *service = new NetworkService(QCoreApplication::instance());
+    return service;
+}
+
+NetworkService::NetworkService(QObject *parent)
+        : QObject(parent), _manager(new QNetworkAccessManager(this)), _cache(new QNetworkDiskCache(this)),
+          _requests(), _queues(), _running() {
+    _cache->setCacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).append("/imagecache"));
+    _manager->setCache(_cache);
+}
+
+NetworkReply *NetworkService::get(const QUrl &url, QObject *owner, QNetworkRequest::CacheLoadControl cacheControl,
+                                  TaskPriority priority) {
+    auto reply = new NetworkReply(url, owner);
+    const auto key = QString::number(cacheControl) + url.toString();
+    auto request = _requests.find(key);
+    if(request == _requests.end()) {
+        request = _requests.insert(key, {url, cacheControl, priority, QList<QPointer<NetworkReply>>(), nullptr});
+        _queues[priority].enqueue(key);
+    } else if(!request->_networkReply && priority > request->_priority) {
+        // Move it up, the entry in the lower queue is skipped when it comes up.
+        request->_priority = priority;
+        _queues[priority].enqueue(key);
+    }
+    request->_replies.push_back(reply);
+    connect(reply, &QObject::destroyed, this, [this, key]() {
+        replyDestroyed(key);
+    });
+    startQueued();
+    return reply;
+}
+
+bool NetworkService::isWanted(const PendingRequest &request) {
+    for(const auto &reply: request._replies) {
+        if(!reply.isNull()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void NetworkService::startQueued() {
+    while(_running.size() < NETWORK_MAX_RUNNING_REQUESTS && !_queues.isEmpty()) {
+        auto queue = _queues.end() - 1; // Highest priority first
+        const auto priority = queue.key();
+        const auto key = queue->dequeue();
+        if(queue->isEmpty()) {
+            _queues.erase(queue);
+        }
+        auto pending = _requests.find(key);
+        if(pending == _requests.end() || pending->_networkReply || pending->_priority != priority) {
+            continue; // Done, running or moved to a higher priority queue.
+        }
+        if(!isWanted(*pending)) {
+            _requests.erase(pending); // Everyone who asked for it is gone.
+            continue;
+        }
+        QNetworkRequest request(pending->_url);
+        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, pending->_cacheControl);
+        request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+        auto networkReply = _manager->get(request);
+        connect(networkReply, &QNetworkReply::finished, this, &NetworkService::requestFinished);
+        pending->_networkReply = networkReply;
+        _running.insert(networkReply, key);
+    }
+}
+
+void NetworkService::replyDestroyed(const QString &key) {
+    // Queued requests nobody wants are dropped when they come up, running ones free their slot.
+    const auto pending = _requests.constFind(key);
+    if(pending != _requests.constEnd() && pending->_networkReply && !isWanted(*pending)) {
+        pending->_networkReply->abort(); // Finishes it right away
+    }
+}
+
+void NetworkService::requestFinished() {
+    auto networkReply = qobject_cast<QNetworkReply *>(sender());
+    const auto key = _running.take(networkReply);
+    const auto pending = _requests.take(key);
+    const auto data = networkReply->readAll();
+    for(const auto &reply: pending._replies) {
+        if(reply) {
+            reply->_error = networkReply->error();
+            reply->_errorString = networkReply->errorString();
+            reply->_data = data;
+            emit reply->finished();
+        }
+    }
+    networkReply->deleteLater();
+    startQueued();
+}
@@ -0,0 +1,117 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <QHash>
+#include <QMap>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QUrl>
+#include "TaskScheduler.h"
+
+class QNetworkAccessManager;
+
+class QNetworkDiskCache;
+
+// One caller's view of a request made through NetworkService. It is owned by the object
+// passed to NetworkService::get(), and deleting it early just drops the result.
+class NetworkReply : public QObject {
+Q_OBJECT
+
+public:
+    const QUrl &url() const {
+        return _url;
+    }
+
+    bool isOk() const {
+        return _error == QNetworkReply::NoError;
+    }
+
+    const QString &errorString() const {
+        return _errorString;
+    }
+
+    const QByteArray &data() const {
+        return _data;
+    }
+
+signals:
+
+    void finished();
+
+private:
+    friend class NetworkService;
+
+    NetworkReply(const QUrl &url, QObject *owner)
+            : QObject(owner), _url(url), _error(QNetworkReply::NoError), _errorString(), _data() { }
+
+    QUrl _url;
+    QNetworkReply::NetworkError _error;
+    QString _errorString;
+    QByteArray _data;
+};
+
+// Process wide HTTP access. All requests share one QNetworkAccessManager, so connections to a
+// host are kept alive and reused, and one disk cache. At most a few requests run at a time,
+// the rest are queued by priority, and identical requests that are in flight or queued are made
+// only once. A request is dropped, or aborted if it's running, once all its replies are deleted.
+class NetworkService : public QObject {
+Q_OBJECT
+
+public:
+    static NetworkService *instance();
+
+    NetworkReply *get(const QUrl &url, QObject *owner,
+                      QNetworkRequest::CacheLoadControl cacheControl = QNetworkRequest::PreferNetwork,
+                      TaskPriority priority = TaskPriorityNormal);
+
+    // The shared disk cache, for reading cached responses directly.
+    QNetworkDiskCache *cache() const {
+        return _cache;
+    }
+
+private slots:
+
+    void requestFinished();
+
+private:
+    struct PendingRequest {
+        QUrl _url;
+        QNetworkRequest::CacheLoadControl _cacheControl;
+        TaskPriority _priority; // Highest priority asked for, the queue it's taken from
+        QList<QPointer<NetworkReply>> _replies;
+        QNetworkReply *_networkReply; // Once running
+    };
+
+    explicit NetworkService(QObject *parent);
+
+    void startQueued();
+
+    void replyDestroyed(const QString &key);
+
+    static bool isWanted(const PendingRequest &request);
+
+    QNetworkAccessManager *_manager;
+    QNetworkDiskCache *_cache;
+    QHash<QString, PendingRequest> _requests; // Queued and running, by cache control and URL
+    QMap<TaskPriority, QQueue<QString>> _queues;
+    QHash<QNetworkReply *, QString> _running;
+};
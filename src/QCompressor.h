@@ -17,6 +17,7 @@
 
 #include <QtGui>
 #include <QByteArray>
+#include "TaskScheduler.h"
 #ifdef Q_OS_WIN
 #include <QtZlib/zlib.h>
 #else
@@ -28,7 +29,7 @@
 #define GZIP_WINDOWS_BIT 15 + 16
 #define GZIP_CHUNK_SIZE 32 * 1024
 
-class QCompressor : public QThread {
+class QCompressor : public WorkerTask {
 Q_OBJECT
 
 
@@ -36,10 +37,14 @@ public:
     virtual void run() override;
 
     explicit QCompressor(const QByteArray &input, bool compress = false)
-            : QThread(), _input(input), _output(), _compress(compress), _level(-1) { }
+            : WorkerTask(TaskPriorityNormal), _input(input), _output(), _compress(compress), _level(-1) { }
 
     virtual ~QCompressor() override { }
 
+    const QByteArray &output() const {
+        return _output;
+    }
+
 
 signals:
 
@@ -19,8 +19,11 @@
 
 
 #define MAP_LEGEND_TEXT "Map Legend"
+#define OVERVIEW_IMAGE_SIZE QSize(800, 800)
+// Number of rows after the selected one to load images for ahead of time.
+#define PREFETCH_ROWS 3
 
-RouteViewer::RouteViewer(const RouteResult &result, QWidget *parent) : QMainWindow(parent), _ui(new Ui::RouteViewer), _iconLoader(nullptr), _imageLoader(nullptr) {
+RouteViewer::RouteViewer(const RouteResult &result, QWidget *parent) : QMainWindow(parent), _ui(new Ui::RouteViewer), _iconLoader(nullptr), _imageLoader(nullptr), _prefetches(nullptr) {
     _ui->setupUi(this);
     QTableView *table = _ui->tableView;
     _routeModel = new RouteTableModel(this, result);
@@ -126,7 +129,7 @@ void RouteViewer::updateSettlementInfo() {
 
     delete _iconLoader;
     _iconLoader = new ImageLoader(_ui->settlementIcon);
-    _iconLoader->startDownload(settlementType->imageNamed(SettlementType::IMAGE_BASE_ICON));
+    _iconLoader->startDownload(settlementType->imageUrl(SettlementImageIcon));
 
    // _ui->largeImage->setPixmap(QPixmap(":/noimage.png"));
     delete _imageLoader;
@@ -137,21 +140,46 @@ void RouteViewer::updateSettlementInfo() {
     _ui->imageList->clear();
     _ui->imageList->addItems(images);
 
-    QString preferredMap = images[0];
-    if(images.contains(SettlementType::IMAGE_PATHMAP)) {
-        preferredMap = SettlementType::IMAGE_PATHMAP;
-    } else if(images.contains(SettlementType::IMAGE_CORE)) {
-        preferredMap = SettlementType::IMAGE_CORE;
-    } else  if(images.contains(SettlementType::IMAGE_COREFULLMAP)) {
-        preferredMap = SettlementType::IMAGE_COREFULLMAP;
-    } else if(images.contains(SettlementType::IMAGE_OVERVIEW)) {
-        preferredMap = SettlementType::IMAGE_OVERVIEW;
-    } else if(images.contains(SettlementType::IMAGE_SATELLITE)) {
-        preferredMap = SettlementType::IMAGE_SATELLITE;
+    auto preferredImage = preferredOverviewImage(settlementType);
+    if(preferredImage == SettlementImageCount) {
+        _ui->imageList->setCurrentText(images[0]);
+        loadOverviewImage(settlementType->imageNamed(images[0]));
+    } else {
+        _ui->imageList->setCurrentText(SettlementType::imageTitle(preferredImage));
+        loadOverviewImage(settlementType->imageUrl(preferredImage));
     }
-    _ui->imageList->setCurrentText(preferredMap);
-    loadOverviewImage(settlementType->imageNamed(preferredMap));
 
+    prefetchImages(row + 1);
+}
+
+SettlementImage RouteViewer::preferredOverviewImage(const SettlementType *settlementType) {
+    for(auto image: {SettlementImagePathMap, SettlementImageCore, SettlementImageCoreFullMap,
+                     SettlementImageOverview, SettlementImageSatellite}) {
+        if(settlementType->hasImage(image)) {
+            return image;
+        }
+    }
+    return SettlementImageCount;
+}
+
+void RouteViewer::prefetchImages(int firstRow) {
+    // Prefetches for rows that are no longer ahead are cancelled. The old ones are deleted after
+    // the new ones are started, so downloads both sets want are shared rather than restarted.
+    auto previous = _prefetches;
+    _prefetches = new QObject(this);
+    for(int row = firstRow; row < firstRow + PREFETCH_ROWS; row++) {
+        const auto settlementData = _routeModel->result().getSettlementAtIndex(row);
+        if(!settlementData) {
+            break;
+        }
+        const auto settlementType = settlementData->settlement().type();
+        ImageLoader::prefetch(settlementType->imageUrl(SettlementImageIcon), QSize(), _prefetches);
+        const auto preferredImage = preferredOverviewImage(settlementType);
+        ImageLoader::prefetch(preferredImage == SettlementImageCount
+                              ? settlementType->imageNamed(settlementType->imageTitles().value(0))
+                              : settlementType->imageUrl(preferredImage), OVERVIEW_IMAGE_SIZE, _prefetches);
+    }
+    delete previous;
 }
 
 void RouteViewer::setFlag(const Settlement &settlement, QString key, SettlementFlags flag) {
@@ -166,8 +194,9 @@ void RouteViewer::setFlag(const Settlement &settlement, QString key, SettlementF
 }
 
 void RouteViewer::loadOverviewImage(const QUrl &url) {
+    delete _imageLoader;
     _imageLoader = new ImageLoader(_ui->largeImage);
-    _imageLoader->setMaxSize(QSize(800, 800));
+    _imageLoader->setMaxSize(OVERVIEW_IMAGE_SIZE);
     _imageLoader->startDownload(url);
 }
 
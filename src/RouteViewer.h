@@ -53,7 +53,14 @@ private:
 
     ImageLoader *_iconLoader;
     ImageLoader *_imageLoader;
+    QObject *_prefetches; // Owns the prefetching loaders for the rows after the selected one
 
     void loadOverviewImage(const QUrl &url);
+
+    // Loads the icons and preferred overview images of the rows after the selected one into
+    // the pixmap cache, so stepping through the route shows them right away.
+    void prefetchImages(int firstRow);
+
+    static SettlementImage preferredOverviewImage(const SettlementType *settlementType);
 };
 
@@ -0,0 +1,155 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SettlementIndex.h"
+#include "System.h"
+
+void SettlementIndex::build(const SystemList *systems) {
+    _systems = systems;
+    _flags.clear();
+    _threat.clear();
+    _size.clear();
+    _distance.clear();
+    _system.clear();
+    _planet.clear();
+    _settlement.clear();
+    _keyLookup.clear();
+    _shortKeyLookup.clear();
+
+    for(int s = 0; s < systems->size(); s++) {
+        const auto &system = systems->at(s);
+        const auto &planets = system.planets();
+        for(int p = 0; p < planets.size(); p++) {
+            const auto &planet = planets[p];
+            const auto &settlements = planet.settlements();
+            for(int i = 0; i < settlements.size(); i++) {
+                const auto &settlement = settlements[i];
+                const int index = _flags.size();
+                _flags.push_back(settlement.flags());
+                _threat.push_back(static_cast<uint8_t>(settlement.threatLevel()));
+                _size.push_back(static_cast<uint8_t>(settlement.size()));
+                _distance.push_back(planet.distance());
+                _system.push_back(s);
+                _planet.push_back(p);
+                _settlement.push_back(i);
+                _keyLookup.insertMulti(makeKey(system.name(), planet.name(), settlement.name()), index);
+                _shortKeyLookup.insertMulti(makeKey(system.name(), QString(), settlement.name()), index);
+            }
+        }
+    }
+}
+
+void SettlementIndex::recordScan(const QString &key, const QDateTime &timestamp,
+                                 VisitedSettlements &visited) const {
+    visited.resize(size());
+    const auto time = VisitedSettlements::toScanTime(timestamp);
+    for(auto index: _keyLookup.values(key)) {
+        visited.recordScan(index, time, true);
+    }
+    for(auto index: _shortKeyLookup.values(key)) {
+        visited.recordScan(index, time, false);
+    }
+}
+
+QVector<int> SettlementIndex::filter(const SettlementFilter &filter) const {
+    const auto count = size();
+    const auto flags = _flags.constData();
+    const auto threat = _threat.constData();
+    const auto sizes = _size.constData();
+    const auto distance = _distance.constData();
+
+    const auto flagMask = filter._flagMask;
+    const auto requiredFlags = filter._requiredFlags;
+    const auto rejectedSizes = filter._rejectedSizes;
+    const auto rejectedThreatLevels = filter._rejectedThreatLevels;
+    const auto minDistance = filter._minDistance;
+    const auto maxDistance = filter._maxDistance;
+
+    // Branch free predicate pass over the columns so the compiler can vectorize it,
+    // followed by a compaction of the matching indices.
+    QVector<uint8_t> keep(count);
+    auto keepData = keep.data();
+    for(int i = 0; i < count; i++) {
+        keepData[i] = static_cast<uint8_t>(((flags[i] & flagMask) == requiredFlags)
+                                           & ((sizes[i] & rejectedSizes) == 0)
+                                           & ((threat[i] & rejectedThreatLevels) == 0)
+                                           & (distance[i] > minDistance)
+                                           & (distance[i] <= maxDistance));
+    }
+    if(filter._visited && filter._visited->size() == count) {
+        const auto scanTimes = filter._visited->scanTimes();
+        const auto since = filter._visitedSince;
+        for(int i = 0; i < count; i++) {
+            keepData[i] &= static_cast<uint8_t>(scanTimes[i] <= since);
+        }
+    }
+
+    QVector<int> matches;
+    for(int i = 0; i < count; i++) {
+        if(keepData[i]) {
+            matches.push_back(i);
+        }
+    }
+    return matches;
+}
+
+int SettlementIndex::countSystems(const QVector<int> &matches) const {
+    int count = 0;
+    int lastSystem = -1;
+    for(auto index: matches) {
+        if(_system[index] != lastSystem) {
+            lastSystem = _system[index];
+            ++count;
+        }
+    }
+    return count;
+}
+
+QVector<int> SettlementIndex::matchingSystems(const QVector<int> &matches) const {
+    QVector<int> systems;
+    for(auto index: matches) {
+        if(systems.isEmpty() || systems.last() != _system[index]) {
+            systems.push_back(_system[index]);
+        }
+    }
+    return systems;
+}
+
+SystemList SettlementIndex::systemsForMatches(const QVector<int> &matches) const {
+    SystemList result;
+    if(!_systems) {
+        return result;
+    }
+    int i = 0;
+    const int count = matches.size();
+    while(i < count) {
+        const auto systemIndex = _system[matches[i]];
+        const auto &system = _systems->at(systemIndex);
+        PlanetList planets;
+        while(i < count && _system[matches[i]] == systemIndex) {
+            const auto planetIndex = _planet[matches[i]];
+            const auto &planet = system.planets()[planetIndex];
+            SettlementList settlements;
+            while(i < count && _system[matches[i]] == systemIndex && _planet[matches[i]] == planetIndex) {
+                settlements.push_back(planet.settlements()[_settlement[matches[i]]]);
+                ++i;
+            }
+            planets.push_back(Planet(planet.name(), planet.distance(), std::move(settlements)));
+        }
+        result.push_back(System(system.name(), std::move(planets), system.position()));
+    }
+    return result;
+}
@@ -0,0 +1,178 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <QBitArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <base/integral_types.h>
+
+class System;
+
+typedef QList<System> SystemList;
+
+// One commander's last datalink scan time of each settlement in a SettlementIndex. Scans are
+// resolved to settlement indices by SettlementIndex::recordScan() as they come in, so the
+// visited test when filtering is a read of the time array.
+class VisitedSettlements {
+public:
+    VisitedSettlements() : _scanTimes(), _planetScans() { }
+
+    // Scan times are stored as seconds since the epoch, 0 is never.
+    static quint32 toScanTime(const QDateTime &timestamp) {
+        return static_cast<quint32>(qBound<qint64>(1, timestamp.toMSecsSinceEpoch() / 1000, UINT32_MAX));
+    }
+
+    const quint32 *scanTimes() const {
+        return _scanTimes.constData();
+    }
+
+    int size() const {
+        return _scanTimes.size();
+    }
+
+private:
+    friend class SettlementIndex;
+
+    void resize(int size) {
+        if(_scanTimes.size() != size) {
+            _scanTimes.fill(0, size);
+            _planetScans.fill(false, size);
+        }
+    }
+
+    // A scan recorded with the planet name takes precedence over one recorded without it.
+    void recordScan(int settlement, quint32 time, bool withPlanet) {
+        if(withPlanet && !_planetScans.testBit(settlement)) {
+            _planetScans.setBit(settlement);
+            _scanTimes[settlement] = time;
+        } else if(withPlanet == _planetScans.testBit(settlement)) {
+            _scanTimes[settlement] = qMax(_scanTimes[settlement], time);
+        }
+    }
+
+    QVector<quint32> _scanTimes;
+    QBitArray _planetScans;
+};
+
+// The settlement filter from the main window, in the form evaluated by SettlementIndex::filter().
+struct SettlementFilter {
+    SettlementFilter()
+            : _flagMask(0), _requiredFlags(0), _rejectedSizes(0), _rejectedThreatLevels(0), _minDistance(-1),
+              _maxDistance(INT32_MAX), _visited(nullptr), _visitedSince(0) { }
+
+    void requireFlags(int32 flags) {
+        _flagMask |= flags;
+        _requiredFlags |= flags;
+    }
+
+    void excludeFlags(int32 flags) {
+        _flagMask |= flags;
+    }
+
+    void allowSizes(int32 sizes) {
+        _rejectedSizes = static_cast<uint8_t>(~sizes);
+    }
+
+    void allowThreatLevels(int32 threatLevels) {
+        _rejectedThreatLevels = static_cast<uint8_t>(~threatLevels);
+    }
+
+    // Planets without a known distance are stored with distance 0.
+    void excludeUnknownDistance() {
+        _minDistance = 0;
+    }
+
+    void setMaxDistance(int32 maxDistance) {
+        _maxDistance = maxDistance ? maxDistance : INT32_MAX;
+    }
+
+    // Exclude settlements scanned after since.
+    void setExcludeVisited(const VisitedSettlements *visited, const QDateTime &since) {
+        _visited = visited;
+        _visitedSince = VisitedSettlements::toScanTime(since);
+    }
+
+    int32 _flagMask;
+    int32 _requiredFlags;
+    uint8_t _rejectedSizes;
+    uint8_t _rejectedThreatLevels;
+    int32 _minDistance;
+    int32 _maxDistance;
+    const VisitedSettlements *_visited;
+    quint32 _visitedSince;
+};
+
+// Columnar copy of the settlement data, built by SystemLoader::loadSettlements(). Filtering
+// runs over these arrays and yields settlement indices; System objects are only assembled
+// for the matches when a route is actually requested.
+class SettlementIndex {
+public:
+    SettlementIndex() : _systems(nullptr) { }
+
+    void build(const SystemList *systems);
+
+    // Point the index at another copy of the system list it was built from.
+    void setSystems(const SystemList *systems) {
+        _systems = systems;
+    }
+
+    const SystemList *systems() const {
+        return _systems;
+    }
+
+    int systemIndex(int settlement) const {
+        return _system[settlement];
+    }
+
+    // Record a settlement scan, by key (see makeKey()), for the settlements it matches.
+    void recordScan(const QString &key, const QDateTime &timestamp, VisitedSettlements &visited) const;
+
+    QVector<int> filter(const SettlementFilter &filter) const;
+
+    int countSystems(const QVector<int> &matches) const;
+
+    // Distinct system indices of the given (ordered) settlement matches.
+    QVector<int> matchingSystems(const QVector<int> &matches) const;
+
+    SystemList systemsForMatches(const QVector<int> &matches) const;
+
+    int size() const {
+        return _flags.size();
+    }
+
+    static QString makeKey(const QString &system, const QString &planet, const QString &settlement) {
+        return QString("%1:%2:%3").arg(system).arg(planet).arg(settlement).toLower();
+    }
+
+private:
+    const SystemList *_systems;
+
+    QVector<int32> _flags;
+    QVector<uint8_t> _threat;
+    QVector<uint8_t> _size;
+    QVector<int32> _distance;
+    QVector<int32> _system;
+    QVector<int32> _planet;
+    QVector<int32> _settlement;
+
+    QHash<QString, int> _keyLookup;
+    QHash<QString, int> _shortKeyLookup;
+};
@@ -17,10 +17,14 @@
 
 
 #include <QFile>
+#include <QHash>
+#include <QtConcurrent>
 #include <QTextStream>
 #include <QDebug>
 #include "System.h"
 #include "AStarRouter.h"
+#include "QCompressor.h"
+#include "SystemSnapshot.h"
 
 #define SETTLEMENT_TYPE_FIELD_COUNT 17
 #define EXPECTED_FIELD_COUNT 27
@@ -29,32 +33,59 @@
 #define READ_FLOAT (*(it++)).toFloat()
 #define READ_BOOL (READ_INT == 1)
 #define READ_STR (*(it++))
-#define READ_URL QUrl(READ_STR)
 #define SKIP_FIELD do { it++; } while(0)
 #define READ_MATERIAL (READ_FLOAT > 0.000)
-#define READ_URL_JPEG(X) QUrl X; do { \
-    auto url = READ_STR; \
-    if(url.length()) { \
-        url += ".jpg"; \
-        X = QUrl(url); \
-    }\
-} while(0)
 
 void SystemLoader::run() {
-    QFile distances(":/body_distances.json");
-    if(!distances.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return;
+    SystemSnapshot snapshot(SystemSnapshot::hashResources(
+            {":/systems.txt.gz", ":/valuable-systems.csv.gz", ":/dbdump.csv", ":/basetypes.csv",
+             ":/body_distances.tsv"}));
+    if(loadSnapshot(snapshot)) {
+        emit progress(100);
+        emit sortingSystems();
+        _router->sortedSystemListLoaded();
+    } else {
+        // Decompress the two system lists in parallel while the distances are loaded.
+        auto valueBytes = QtConcurrent::run(TaskScheduler::instance()->pool(), &SystemLoader::decompressResource,
+                                            QString(":/valuable-systems.csv.gz"));
+        _bytes = decompressResource(":/systems.txt.gz");
+        _bodyDistances.load(":/body_distances.tsv");
+        _valueBytes = valueBytes.result();
+        loadSystemFromTextFile();
+        loadValueSystemFromTextFile();
+        loadSettlements();
+        _bytes.clear();
+        _valueBytes.clear();
+        emit sortingSystems();
+        _router->sortSystemList();
+        snapshot.save(_router->systems(), _systems, _settlementTypes);
     }
-    auto distanceDoc = QJsonDocument::fromJson(distances.readAll());
-    if(distanceDoc.isObject()) {
-        _bodyDistances = distanceDoc.object();
+    _router->mergeSortedSystems(_cachedSystems);
+    _router->buildValuableSystemIndex();
+    emit systemsLoaded(_systems, _settlementIndex);
+}
+
+QByteArray SystemLoader::decompressResource(const QString &resource) {
+    QFile file(resource);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
     }
-    loadSystemFromTextFile();
-    loadValueSystemFromTextFile();
-    loadSettlements();
-    emit sortingSystems();
-    _router->sortSystemList();
-    emit systemsLoaded(_systems);
+    QCompressor compressor(file.readAll());
+    compressor.run();
+    return compressor.output();
+}
+
+bool SystemLoader::loadSnapshot(const SystemSnapshot &snapshot) {
+    SystemList routerSystems;
+    if(!snapshot.load(routerSystems, _systems, _settlementTypes)) {
+        return false;
+    }
+    _router->reserveSystemSpace(routerSystems.size());
+    for(auto &system: routerSystems) {
+        _router->addSystem(std::move(system));
+    }
+    _settlementIndex.build(&_systems);
+    return true;
 }
 
 
@@ -96,12 +127,12 @@ void SystemLoader::loadValueSystemFromTextFile() {
         auto y = READ_FLOAT;
         auto z = READ_FLOAT;
 
-        QList<int8_t> numPlanets;
-        numPlanets.append(READ_CHAR); // elw
-        numPlanets.append(READ_CHAR); // ww
-        numPlanets.append(READ_CHAR); // wwt
-        numPlanets.append(READ_CHAR); // aw
-        numPlanets.append(READ_CHAR); // tf
+        ValuableBodyCounts numPlanets;
+        numPlanets[ValuableBodyFlagsEW] = READ_CHAR; // elw
+        numPlanets[ValuableBodyFlagsWW] = READ_CHAR; // ww
+        numPlanets[ValuableBodyFlagsWT] = READ_CHAR; // wwt
+        numPlanets[ValuableBodyFlagsAW] = READ_CHAR; // aw
+        numPlanets[ValuableBodyFlagsTF] = READ_CHAR; // tf
 
         System *current = _router->findSystemByName(name);
         if(current) {
@@ -163,23 +194,16 @@ void SystemLoader::loadSettlementTypes() {
         SKIP_FIELD; // Variation continued
         SKIP_FIELD; // Type
         auto economy = READ_STR; // Military etc
-        auto iconUrl = READ_URL;
-
-        READ_URL_JPEG(showUrl);
-        READ_URL_JPEG(coreFullUrl);
-        READ_URL_JPEG(overviewUrl);
-        READ_URL_JPEG(pathUrl);
-        READ_URL_JPEG(overview3DUrl);
-        READ_URL_JPEG(coreUrl);
-        READ_URL_JPEG(satelliteUrl);
         auto settlementType = new SettlementType(size, security, economy);
-        settlementType->addImage(SettlementType::IMAGE_BASE_ICON, iconUrl);
-        settlementType->addImage(SettlementType::IMAGE_CORE, coreUrl.isValid() ? coreUrl : showUrl);
-        settlementType->addImage(SettlementType::IMAGE_COREFULLMAP, coreFullUrl);
-        settlementType->addImage(SettlementType::IMAGE_PATHMAP, pathUrl);
-        settlementType->addImage(SettlementType::IMAGE_OVERVIEW, overviewUrl);
-        settlementType->addImage(SettlementType::IMAGE_OVERVIEW3D, overview3DUrl);
-        settlementType->addImage(SettlementType::IMAGE_SATELLITE, satelliteUrl);
+        settlementType->setImageSource(SettlementImageIcon, READ_STR);
+        auto show = READ_STR;
+        settlementType->setImageSource(SettlementImageCoreFullMap, READ_STR);
+        settlementType->setImageSource(SettlementImageOverview, READ_STR);
+        settlementType->setImageSource(SettlementImagePathMap, READ_STR);
+        settlementType->setImageSource(SettlementImageOverview3D, READ_STR);
+        auto core = READ_STR;
+        settlementType->setImageSource(SettlementImageCore, core.isEmpty() ? show : core);
+        settlementType->setImageSource(SettlementImageSatellite, READ_STR);
         _settlementTypes[layout] = settlementType;
     }
 }
@@ -195,9 +219,22 @@ void SystemLoader::loadSettlements() {
 
     QStringList lines(QString(systemData.readAll()).split("\n"));
     lines.removeFirst(); // Header
-    QMap<QString, System *> lookup;
-    _systems.clear();
-    _systems.reserve(lines.size());
+
+    // Settlements are grouped by system and planet while reading, and the System objects are
+    // built in one pass afterwards. Systems and planets keep the order they first appear in.
+    struct PendingPlanet {
+        QString _name;
+        int _distance;
+        SettlementList _settlements;
+    };
+    struct PendingSystem {
+        QString _name;
+        QVector3D _position;
+        QHash<QString, int> _planetLookup;
+        QVector<PendingPlanet> _planets;
+    };
+    QHash<QString, int> systemLookup;
+    QVector<PendingSystem> pendingSystems;
     for(const auto &qline: lines) {
         QStringList line = qline.split("\t");
         if(line.size() < EXPECTED_FIELD_COUNT) {
@@ -250,38 +287,43 @@ void SystemLoader::loadSettlements() {
 //        SKIP_FIELD; // Settlement size, uses settlement raw data.
         SKIP_FIELD; // idx
 
-        Settlement settlement(name, flags, threat, type);
-        const auto distance = getDistance(system, planet);
-        if(lookup.contains(system)) {
-            lookup[system]->addSettlement(planet, settlement, distance);
-        } else {
-            Planet planetObj(planet, distance, settlement);
-            System systemObj(system, planetObj, x, y, z);
-            _systems.push_back(systemObj);
-            lookup[system] = &_systems.last();
-
-            if(!_router->findSystemByName(system)) {
-                _router->addSystem(systemObj);
-            }
+        auto systemIt = systemLookup.constFind(system);
+        if(systemIt == systemLookup.constEnd()) {
+            systemIt = systemLookup.insert(system, pendingSystems.size());
+            PendingSystem pendingSystem;
+            pendingSystem._name = system;
+            pendingSystem._position = QVector3D(x, y, z);
+            pendingSystems.push_back(std::move(pendingSystem));
         }
+        auto &pendingSystem = pendingSystems[*systemIt];
+        auto planetIt = pendingSystem._planetLookup.constFind(planet);
+        if(planetIt == pendingSystem._planetLookup.constEnd()) {
+            planetIt = pendingSystem._planetLookup.insert(planet, pendingSystem._planets.size());
+            PendingPlanet pendingPlanet;
+            pendingPlanet._name = planet;
+            pendingPlanet._distance = _bodyDistances.distance(system, planet);
+            pendingSystem._planets.push_back(std::move(pendingPlanet));
+        }
+        pendingSystem._planets[*planetIt]._settlements.push_back(Settlement(name, flags, threat, type));
     }
-}
-
-void SystemLoader::dataDecompressed(const QByteArray &bytes) {
-    _bytes = bytes;
-    if(!_bytes.isEmpty() && !_valueBytes.isEmpty()) {
-        start();
-    }
-}
 
-void SystemLoader::valuableSystemDataDecompressed(const QByteArray &bytes) {
-    _valueBytes = bytes;
-    if(!_bytes.isEmpty() && !_valueBytes.isEmpty()) {
-        start();
+    _systems.clear();
+    _systems.reserve(pendingSystems.size());
+    for(auto &pendingSystem: pendingSystems) {
+        PlanetList planets;
+        planets.reserve(pendingSystem._planets.size());
+        for(auto &pendingPlanet: pendingSystem._planets) {
+            planets.push_back(Planet(pendingPlanet._name, pendingPlanet._distance,
+                                     std::move(pendingPlanet._settlements)));
+        }
+        _systems.push_back(System(pendingSystem._name, std::move(planets), pendingSystem._position));
+        if(!_router->findSystemByName(pendingSystem._name)) {
+            _router->addSystem(_systems.last());
+        }
     }
+    _settlementIndex.build(&_systems);
 }
 
-
 QString System::formatDistance(int64 dist) {
     if(dist > 0) {
         return QString("%1.%2").arg(dist / 10).arg(dist % 10);
@@ -291,10 +333,10 @@ QString System::formatDistance(int64 dist) {
 }
 
 System::System(AStarSystemNode *system)
-        : _name(system->name()), _position(system->position()) {}
+        : _name(system->name()), _position(system->position()), _numPlanets() {}
 
 void System::addSettlement(const QString &planetName, const Settlement &settlement, int distance) {
-    for(auto planet: _planets) {
+    for(auto &planet: _planets) {
         if(planet.name() == planetName) {
             planet.addSettlement(settlement);
             return;
@@ -316,41 +358,68 @@ System::System(const QJsonObject &jsonObject)
 
 SystemLoader::~SystemLoader() {}
 
-int SystemLoader::getDistance(const QString &system, const QString &planet) {
-    auto systemValue = _bodyDistances.value(system);
-    return systemValue.isObject() ? systemValue.toObject().value(planet).toInt(0) : 0;
+
+const QString &SettlementType::imageTitle(SettlementImage image) {
+    static const std::array<QString, SettlementImageCount> titles = {{
+        "Icon", "Core Map", "Core Full Map", "Datapoint Path Map", "Overview Map", "3D Overview", "Satellite Map"
+    }};
+    return titles[image];
 }
 
+const QUrl &SettlementType::imageUrl(SettlementImage image) const {
+    const auto bit = static_cast<uint8_t>(1 << image);
+    if(!(_resolvedImages & bit)) {
+        const auto &source = _imageSources[image];
+        if(!source.isEmpty()) {
+            _imageUrls[image] = QUrl(image == SettlementImageIcon ? source : source + ".jpg");
+        }
+        _resolvedImages |= bit;
+    }
+    return _imageUrls[image];
+}
 
-const QString SettlementType::IMAGE_BASE_ICON = "Icon";
-const QString SettlementType::IMAGE_SATELLITE = "Satellite Map";
-const QString SettlementType::IMAGE_COREFULLMAP = "Core Full Map";
-const QString SettlementType::IMAGE_OVERVIEW = "Overview Map";
-const QString SettlementType::IMAGE_PATHMAP = "Datapoint Path Map";
-const QString SettlementType::IMAGE_OVERVIEW3D = "3D Overview";
-const QString SettlementType::IMAGE_CORE = "Core Map";
+const QUrl &SettlementType::imageNamed(const QString &title) const {
+    for(int i = 0; i < SettlementImageCount; i++) {
+        const auto image = static_cast<SettlementImage>(i);
+        if(imageTitle(image) == title) {
+            return imageUrl(image);
+        }
+    }
+    static const QUrl noImage;
+    return noImage;
+}
+
+void SettlementType::setImageSource(SettlementImage image, const QString &source) {
+    _imageSources[image] = source;
+    _imageUrls[image] = QUrl();
+    _resolvedImages &= ~(1 << image);
+
+    _imageTitles.clear();
+    for(int i = 0; i < SettlementImageCount; i++) {
+        if(i != SettlementImageIcon && !_imageSources[i].isEmpty()) {
+            _imageTitles.append(imageTitle(static_cast<SettlementImage>(i)));
+        }
+    }
+    _imageTitles.sort();
+}
 
 const QString System::formatPlanets() const {
     QStringList planets;
-    if(_numPlanets.count() == ValuableBodyFlagsCount) {
-        addSystemString(planets, ValuableBodyFlagsEW, "Earth-like World");
-        addSystemString(planets, ValuableBodyFlagsWT, "Water World (TF)");
-        addSystemString(planets, ValuableBodyFlagsWW, "Water World");
-        addSystemString(planets, ValuableBodyFlagsAW, "Ammonia World");
-        addSystemString(planets, ValuableBodyFlagsTF, "Other TF");
-    }
+    addSystemString(planets, ValuableBodyFlagsEW, "Earth-like World");
+    addSystemString(planets, ValuableBodyFlagsWT, "Water World (TF)");
+    addSystemString(planets, ValuableBodyFlagsWW, "Water World");
+    addSystemString(planets, ValuableBodyFlagsAW, "Ammonia World");
+    addSystemString(planets, ValuableBodyFlagsTF, "Other TF");
     return planets.join("\n");
 }
 
 int32 System::estimatedValue() const {
     int32 value = 0;
-    if(_numPlanets.count() == ValuableBodyFlagsCount) {
-        value += 627 * _numPlanets[ValuableBodyFlagsEW];
-        value += 412 * (_numPlanets[ValuableBodyFlagsWW] - _numPlanets[ValuableBodyFlagsWT]);
-        value += 695 * _numPlanets[ValuableBodyFlagsWT];
-        value += 320 * _numPlanets[ValuableBodyFlagsAW];
-        value += 412 * _numPlanets[ValuableBodyFlagsTF];
-    }
+    value += 627 * _numPlanets[ValuableBodyFlagsEW];
+    value += 412 * (_numPlanets[ValuableBodyFlagsWW] - _numPlanets[ValuableBodyFlagsWT]);
+    value += 695 * _numPlanets[ValuableBodyFlagsWT];
+    value += 320 * _numPlanets[ValuableBodyFlagsAW];
+    value += 412 * _numPlanets[ValuableBodyFlagsTF];
     return value;
 }
 
@@ -17,16 +17,19 @@
 
 #pragma once
 
+#include <array>
 #include <cmath>
 #include <QString>
 #include <AStar.h>
 #include <QVector3D>
 #include <QJsonObject>
-#include <QThread>
+#include "TaskScheduler.h"
 #include <QDebug>
 #include <QUrl>
 #include <base/integral_types.h>
 #include <QJsonDocument>
+#include "BodyDistances.h"
+#include "SettlementIndex.h"
 
 class AStarSystemNode;
 
@@ -38,6 +41,8 @@ class Planet;
 
 class System;
 
+class SystemSnapshot;
+
 typedef QList<Settlement> SettlementList;
 typedef QList<Planet> PlanetList;
 typedef QList<System> SystemList;
@@ -82,31 +87,33 @@ enum ValuableBodyFlags {
     ValuableBodyFlagsCount
 };
 
+// Number of bodies of each ValuableBodyFlags type, all zero for systems without value data.
+typedef std::array<int8_t, ValuableBodyFlagsCount> ValuableBodyCounts;
 
-class SettlementType {
-public:
-    static const QString IMAGE_BASE_ICON;
-    static const QString IMAGE_SATELLITE;
-    static const QString IMAGE_COREFULLMAP;
-    static const QString IMAGE_OVERVIEW;
-    static const QString IMAGE_PATHMAP;
-    static const QString IMAGE_OVERVIEW3D;
-    static const QString IMAGE_CORE;
 
+enum SettlementImage {
+    SettlementImageIcon,
+    SettlementImageCore,
+    SettlementImageCoreFullMap,
+    SettlementImagePathMap,
+    SettlementImageOverview,
+    SettlementImageOverview3D,
+    SettlementImageSatellite,
+    SettlementImageCount
+};
 
+class SettlementType {
+public:
     SettlementType(SettlementSize size, ThreatLevel securityLevel, const QString &economy)
-            : _size(size), _securityLevel(securityLevel), _economy(economy), _images() {}
+            : _size(size), _securityLevel(securityLevel), _economy(economy), _imageSources(), _imageUrls(),
+              _resolvedImages(0), _imageTitles() {}
 
-    SettlementType(const SettlementType &other)
-            : _size(other._size), _securityLevel(other._securityLevel), _economy(other._economy),
-              _images(other._images) {}
+    SettlementType(const SettlementType &other) = default;
 
-    SettlementType(const SettlementType &&other)
-            : _size(other._size), _securityLevel(other._securityLevel), _economy(std::move(other._economy)),
-              _images(std::move(other._images)) {}
+    SettlementType(SettlementType &&other) noexcept = default;
 
 
-    SettlementType() {}
+    SettlementType() : _resolvedImages(0) {}
 
     SettlementSize size() const {
         return _size;
@@ -120,46 +127,42 @@ public:
         return _economy;
     }
 
+    // The QUrl is only constructed the first time an image is requested.
+    const QUrl &imageUrl(SettlementImage image) const;
 
-    const QUrl imageNamed(const QString &name) const {
-        return _images.contains(name) ? _images[name] : QUrl();
-    }
+    const QUrl &imageNamed(const QString &title) const;
 
-    SettlementType &operator=(const SettlementType &&other) {
-        _size = other._size;
-        _securityLevel = other._securityLevel;
-        _economy = std::move(other._economy);
-        _images = std::move(other._images);
-        return *this;
+    bool hasImage(SettlementImage image) const {
+        return !_imageSources[image].isEmpty();
     }
 
-    SettlementType &operator=(const SettlementType &other) {
-        _size = other._size;
-        _securityLevel = other._securityLevel;
-        _economy = other._economy;
-        _images = other._images;
-        return *this;
-    }
+    SettlementType &operator=(SettlementType &&other) noexcept = default;
 
-    void addImage(const QString &name, const QUrl &url) {
-        if(url.isValid()) {
-            _images[name] = url;
-        }
+    SettlementType &operator=(const SettlementType &other) = default;
+
+    // Source is the URL as stored in basetypes.csv, all images but the icon get a .jpg suffix.
+    void setImageSource(SettlementImage image, const QString &source);
+
+    const QString &imageSource(SettlementImage image) const {
+        return _imageSources[image];
     }
 
-    const QStringList imageTitles() const {
-        auto keys = _images.keys();
-        keys.removeAll(SettlementType::IMAGE_BASE_ICON);
-        keys.sort();
-        return keys;
+    // Titles of the available images except the icon, sorted by name.
+    const QStringList &imageTitles() const {
+        return _imageTitles;
     }
 
+    static const QString &imageTitle(SettlementImage image);
+
 private:
     SettlementSize _size;
     ThreatLevel _securityLevel;
     QString _economy;
 
-    QMap<QString, QUrl> _images;
+    std::array<QString, SettlementImageCount> _imageSources;
+    mutable std::array<QUrl, SettlementImageCount> _imageUrls;
+    mutable uint8_t _resolvedImages;
+    QStringList _imageTitles;
 };
 
 class Settlement {
@@ -170,30 +173,13 @@ public:
                const SettlementType *type = nullptr)
             : _name(name), _flags(flags), _threatLevel(threatLevel), _type(type) {}
 
-    Settlement(const Settlement &&other)
-            : _name(std::move(other._name)), _flags(other._flags), _threatLevel(other._threatLevel),
-              _type(other._type) {
-    }
+    Settlement(Settlement &&other) noexcept = default;
 
-    Settlement(const Settlement &other)
-            : _name(other._name), _flags(other._flags), _threatLevel(other._threatLevel), _type(other._type) {
-    }
+    Settlement(const Settlement &other) = default;
 
-    Settlement &operator=(const Settlement &&other) {
-        _name = std::move(other._name);
-        _flags = other._flags;
-        _threatLevel = other._threatLevel;
-        _type = other._type;
-        return *this;
-    }
+    Settlement &operator=(Settlement &&other) noexcept = default;
 
-    Settlement &operator=(const Settlement &other) {
-        _name = other._name;
-        _flags = other._flags;
-        _threatLevel = other._threatLevel;
-        _type = other._type;
-        return *this;
-    }
+    Settlement &operator=(const Settlement &other) = default;
 
     const QString &name() const {
         return _name;
@@ -235,25 +221,16 @@ public:
     Planet(const QString &name, int distance, const SettlementList &settlements)
             : _name(name), _distance(distance), _settlements(settlements) {}
 
-    Planet(const Planet &&other)
-            : _name(std::move(other._name)), _distance(other._distance), _settlements(std::move(other._settlements)) {}
+    Planet(const QString &name, int distance, SettlementList &&settlements)
+            : _name(name), _distance(distance), _settlements(std::move(settlements)) {}
 
-    Planet(const Planet &other)
-            : _name(other._name), _distance(other._distance), _settlements(other._settlements) {}
+    Planet(Planet &&other) noexcept = default;
 
-    Planet &operator=(const Planet &other) {
-        _name = other._name;
-        _settlements = other._settlements;
-        _distance = other._distance;
-        return *this;
-    }
+    Planet(const Planet &other) = default;
 
-    Planet &operator=(const Planet &&other) {
-        _name = std::move(other._name);
-        _settlements = std::move(other._settlements);
-        _distance = other._distance;
-        return *this;
-    }
+    Planet &operator=(const Planet &other) = default;
+
+    Planet &operator=(Planet &&other) noexcept = default;
 
     const SettlementList &settlements() const {
         return _settlements;
@@ -294,38 +271,25 @@ public:
     System(const QString &system, const PlanetList &planets, const QVector3D &position)
             : _name(system), _planets(planets), _position(position), _numPlanets() {}
 
+    System(const QString &system, PlanetList &&planets, const QVector3D &position)
+            : _name(system), _planets(std::move(planets)), _position(position), _numPlanets() {}
+
     System(const QString &name, const QVector3D &position)
             : _name(name), _position(position), _numPlanets() {}
 
-    System(const System &other)
-            : _name(other._name), _planets(other._planets), _position(other._position),
-              _numPlanets(other._numPlanets) {}
+    System(const System &other) = default;
 
-    System(const System &&other)
-            : _name(std::move(other._name)), _planets(std::move(other._planets)),
-              _position(std::move(other._position)), _numPlanets(std::move(other._numPlanets)) {}
+    System(System &&other) noexcept = default;
 
     System(const QJsonObject &jsonObject);
 
-    System &operator=(const System &other) {
-        _name = other._name;
-        _planets = other._planets;
-        _position = other._position;
-        _numPlanets = other._numPlanets;
-        return *this;
-    }
+    System &operator=(const System &other) = default;
 
-    System &operator=(const System &&other) {
-        _name = std::move(other._name);
-        _planets = std::move(other._planets);
-        _position = std::move(other._position);
-        _numPlanets = std::move(other._numPlanets);
-        return *this;
-    }
+    System &operator=(System &&other) noexcept = default;
 
     System(AStarSystemNode *system);
 
-    virtual ~System();
+    ~System();
 
 // Return distance as a fixed point value with two decimals. Used by TSP
     int64 distance(const System &other) const {
@@ -351,17 +315,23 @@ public:
         return _position;
     }
 
-    void setNumPlanets(const QList<int8_t> &numPlanets) {
+    const ValuableBodyCounts &numPlanets() const {
+        return _numPlanets;
+    }
+
+    void setNumPlanets(const ValuableBodyCounts &numPlanets) {
         _numPlanets = numPlanets;
     }
 
-    bool matchesFilter(const QList<bool> &filter) const {
-        for(int i = 0; i < filter.count() &&  i < _numPlanets.count(); i++) {
-            if(filter[i] && _numPlanets[i] > 0) {
-                return true;
+    // One bit per ValuableBodyFlags type with at least one body in the system.
+    uint8_t valuableBodyTypes() const {
+        uint8_t types = 0;
+        for(int i = 0; i < ValuableBodyFlagsCount; i++) {
+            if(_numPlanets[i] > 0) {
+                types |= 1 << i;
             }
         }
-        return false;
+        return types;
     }
 
     const PlanetList &planets() const { return _planets; }
@@ -379,24 +349,24 @@ public:
 protected:
 
     System(float x, float y, float z)
-            : _position(x, y, z) {}
+            : _position(x, y, z), _numPlanets() {}
 
     float sqr(float val) const { return val * val; }
 
     QString _name;
     PlanetList _planets;
     QVector3D _position;
-    QList<int8_t>  _numPlanets;
+    ValuableBodyCounts _numPlanets;
 
     void addSystemString(QStringList &list, ValuableBodyFlags type, QString name) const;
 };
 
-class SystemLoader : public QThread {
+class SystemLoader : public WorkerTask {
 Q_OBJECT
 
 public:
     SystemLoader(AStarRouter *router)
-            : QThread(), _router(router) {}
+            : WorkerTask(TaskPriorityNormal), _router(router) {}
 
     void run() override;
 
@@ -414,31 +384,38 @@ public:
         return _settlementTypes;
     }
 
+    const SettlementIndex &settlementIndex() const {
+        return _settlementIndex;
+    }
+
+    // Systems looked up earlier (see CoordinateService), sorted by name. They are merged into
+    // the router after the bundled ones, and are not part of the snapshot.
+    void setCachedSystems(const SystemList &systems) {
+        _cachedSystems = systems;
+    }
+
 signals:
 
-    void systemsLoaded(const SystemList &systems);
+    void systemsLoaded(const SystemList &systems, const SettlementIndex &settlementIndex);
 
     void progress(int progress);
 
     void sortingSystems();
 
-public slots:
-
-    void dataDecompressed(const QByteArray &bytes);
-
-    void valuableSystemDataDecompressed(const QByteArray &bytes);
-
 private:
 
     QMap<QString, SettlementType *> _settlementTypes;
     SystemList _systems;
+    SettlementIndex _settlementIndex;
+    SystemList _cachedSystems;
     AStarRouter *_router;
     QByteArray _bytes;
     QByteArray _valueBytes;
-    QJsonObject _bodyDistances;
+    BodyDistances _bodyDistances;
 
     void loadSystemFromTextFile();
     void loadValueSystemFromTextFile();
+    bool loadSnapshot(const SystemSnapshot &snapshot);
 
-    int getDistance(const QString &system, const QString &planet);
+    static QByteArray decompressResource(const QString &resource);
 };
@@ -16,7 +16,7 @@
 
 #include <QListView>
 #include "SystemEntryCoordinateResolver.h"
-#include "EDSMQueryExecutor.h"
+#include "CoordinateService.h"
 
 
 SystemEntryCoordinateResolver::SystemEntryCoordinateResolver(QObject *parent, AStarRouter *router, QLineEdit *lineEdit,
@@ -31,36 +31,42 @@ SystemEntryCoordinateResolver::SystemEntryCoordinateResolver(QObject *parent, AS
     connect(completer, SIGNAL(activated(const QString &)), this, SLOT(onCompletion(const QString &)));
     _lineEdit->setCompleter(completer);
     connect(_lineEdit, SIGNAL(editingFinished()), this, SLOT(onEntry()));
+    auto coordinates = CoordinateService::instance();
+    connect(coordinates, &CoordinateService::coordinatesReceived, this,
+            &SystemEntryCoordinateResolver::systemCoordinatesReceived);
+    connect(coordinates, &CoordinateService::coordinateRequestFailed, this,
+            &SystemEntryCoordinateResolver::systemCoordinatesRequestFailed);
 }
 
 
 
 void SystemEntryCoordinateResolver::downloadSystemCoordinates(const QString &systemName) {
-    if(_pendingLookups.contains(systemName)) {
+    if(_pendingLookups.contains(systemName.toLower())) {
         return;
     }
     _pendingLookups << systemName.toLower();
-    auto executor = EDSMQueryExecutor::systemCoordinateRequest(systemName);
-    connect(executor, &QThread::finished, executor, &QObject::deleteLater);
-    connect(executor, &EDSMQueryExecutor::coordinatesReceived, this, &SystemEntryCoordinateResolver::systemCoordinatesReceived);
-    connect(executor, &EDSMQueryExecutor::coordinateRequestFailed, this,
-            &SystemEntryCoordinateResolver::systemCoordinatesRequestFailed);
-    executor->start();
+    CoordinateService::instance()->lookup(systemName);
     emit systemLookupInitiated(systemName);
 
 }
 
 
 void SystemEntryCoordinateResolver::systemCoordinatesRequestFailed(const QString &systemName) {
-    _pendingLookups.remove(systemName.toLower());
+    // The service is shared, only handle the lookups made here.
+    if(!_pendingLookups.remove(systemName.toLower())) {
+        return;
+    }
     emit systemLookupFailed(systemName);
 }
 
 void SystemEntryCoordinateResolver::systemCoordinatesReceived(const System &system) {
     auto systemName = QString(system.name().toLower());
-    _pendingLookups.remove(systemName);
-    _router->addSystem(system);
-    _router->sortSystemList();
+    if(!_pendingLookups.remove(systemName)) {
+        return;
+    }
+    if(!_router->findSystemByName(system.name())) {
+        _router->insertSystem(system);
+    }
     sendSystemLookupCompleted(system);
 }
 
@@ -82,6 +88,7 @@ void SystemEntryCoordinateResolver::resolve(const QString &systemName) {
     }
     auto system = _router->findSystemByName(systemName);
     if(system) {
+        CoordinateService::instance()->markUsed(system->name());
         sendSystemLookupCompleted(*system);
     } else {
         downloadSystemCoordinates(systemName);
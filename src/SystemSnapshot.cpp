@@ -0,0 +1,232 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include "SystemSnapshot.h"
+#include "System.h"
+
+#define SNAPSHOT_MAGIC 0x45445253
+// Bump whenever the stream layout or the post-processing done by SystemLoader changes.
+#define SNAPSHOT_VERSION 2
+
+namespace {
+    void writeSystem(QDataStream &stream, const System &system, const QMap<const SettlementType *, qint32> &typeIds) {
+        stream << system.name() << system.x() << system.y() << system.z();
+        for(auto count: system.numPlanets()) {
+            stream << static_cast<qint8>(count);
+        }
+        stream << static_cast<qint32>(system.planets().size());
+        for(const auto &planet: system.planets()) {
+            stream << planet.name() << static_cast<qint32>(planet.distance())
+                   << static_cast<qint32>(planet.settlements().size());
+            for(const auto &settlement: planet.settlements()) {
+                stream << settlement.name() << static_cast<qint32>(settlement.flags())
+                       << static_cast<qint32>(settlement.threatLevel()) << typeIds.value(settlement.type(), -1);
+            }
+        }
+    }
+
+    bool readSystem(QDataStream &stream, const QVector<SettlementType *> &types, System &system) {
+        QString name;
+        float x, y, z;
+        stream >> name >> x >> y >> z;
+        ValuableBodyCounts numPlanets;
+        for(auto &count: numPlanets) {
+            qint8 value;
+            stream >> value;
+            count = value;
+        }
+        qint32 planetCount;
+        stream >> planetCount;
+        if(stream.status() != QDataStream::Ok || planetCount < 0) {
+            return false;
+        }
+        PlanetList planets;
+        planets.reserve(planetCount);
+        for(qint32 p = 0; p < planetCount; p++) {
+            QString planetName;
+            qint32 distance, settlementCount;
+            stream >> planetName >> distance >> settlementCount;
+            if(stream.status() != QDataStream::Ok || settlementCount < 0) {
+                return false;
+            }
+            SettlementList settlements;
+            settlements.reserve(settlementCount);
+            for(qint32 i = 0; i < settlementCount; i++) {
+                QString settlementName;
+                qint32 flags, threat, typeId;
+                stream >> settlementName >> flags >> threat >> typeId;
+                if(typeId < 0 || typeId >= types.size()) {
+                    return false;
+                }
+                settlements.push_back(Settlement(settlementName, flags, static_cast<ThreatLevel>(threat), types[typeId]));
+            }
+            planets.push_back(Planet(planetName, distance, std::move(settlements)));
+        }
+        system = System(name, std::move(planets), QVector3D(x, y, z));
+        system.setNumPlanets(numPlanets);
+        return stream.status() == QDataStream::Ok;
+    }
+
+    bool readSystemList(QDataStream &stream, const QVector<SettlementType *> &types, SystemList &systems) {
+        qint32 count;
+        stream >> count;
+        if(stream.status() != QDataStream::Ok || count < 0) {
+            return false;
+        }
+        systems.reserve(count);
+        for(qint32 i = 0; i < count; i++) {
+            System system;
+            if(!readSystem(stream, types, system)) {
+                return false;
+            }
+            systems.push_back(std::move(system));
+        }
+        return true;
+    }
+}
+
+QByteArray SystemSnapshot::hashResources(const QStringList &resources) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(SNAPSHOT_VERSION));
+    for(const auto &resource: resources) {
+        QFile file(resource);
+        if(!file.open(QIODevice::ReadOnly)) {
+            return QByteArray();
+        }
+        hash.addData(resource.toUtf8());
+        hash.addData(&file);
+    }
+    return hash.result();
+}
+
+QString SystemSnapshot::path() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/systems.snapshot";
+}
+
+bool SystemSnapshot::load(SystemList &routerSystems, SystemList &settlementSystems,
+                          QMap<QString, SettlementType *> &settlementTypes) const {
+    if(_inputHash.isEmpty()) {
+        return false;
+    }
+    QFile file(path());
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // Map the file rather than reading it, the stream only copies out the strings it decodes.
+    QByteArray bytes;
+    auto mapped = file.map(0, file.size());
+    if(mapped) {
+        bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), static_cast<int>(file.size()));
+    } else {
+        bytes = file.readAll();
+    }
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic, version;
+    QByteArray hash;
+    stream >> magic >> version >> hash;
+    if(magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION || hash != _inputHash) {
+        return false;
+    }
+
+    qint32 typeCount;
+    stream >> typeCount;
+    if(stream.status() != QDataStream::Ok || typeCount < 0) {
+        return false;
+    }
+    QVector<SettlementType *> types;
+    QMap<QString, SettlementType *> typesByLayout;
+    for(qint32 i = 0; i < typeCount; i++) {
+        QString layout, economy;
+        qint32 size, security;
+        stream >> layout >> size >> security >> economy;
+        auto type = new SettlementType(static_cast<SettlementSize>(size), static_cast<ThreatLevel>(security), economy);
+        for(int image = 0; image < SettlementImageCount; image++) {
+            QString source;
+            stream >> source;
+            type->setImageSource(static_cast<SettlementImage>(image), source);
+        }
+        types.push_back(type);
+        typesByLayout[layout] = type;
+    }
+
+    SystemList routerList, settlementList;
+    if(stream.status() != QDataStream::Ok
+       || !readSystemList(stream, types, routerList)
+       || !readSystemList(stream, types, settlementList)) {
+        qDeleteAll(types);
+        return false;
+    }
+    routerSystems = std::move(routerList);
+    settlementSystems = std::move(settlementList);
+    settlementTypes = std::move(typesByLayout);
+    return true;
+}
+
+bool SystemSnapshot::save(const SystemList &routerSystems, const SystemList &settlementSystems,
+                          const QMap<QString, SettlementType *> &settlementTypes) const {
+    if(_inputHash.isEmpty() || !QDir().mkpath(QFileInfo(path()).absolutePath())) {
+        return false;
+    }
+    QSaveFile file(path());
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    stream << static_cast<quint32>(SNAPSHOT_MAGIC) << static_cast<quint32>(SNAPSHOT_VERSION) << _inputHash;
+
+    // Lookups of unknown layouts leave null entries in the type map, those are not written.
+    QStringList layouts;
+    for(auto it = settlementTypes.constBegin(); it != settlementTypes.constEnd(); ++it) {
+        if(it.value()) {
+            layouts.push_back(it.key());
+        }
+    }
+    QMap<const SettlementType *, qint32> typeIds;
+    stream << static_cast<qint32>(layouts.size());
+    for(const auto &layout: layouts) {
+        auto type = settlementTypes[layout];
+        const qint32 id = typeIds.size();
+        typeIds[type] = id;
+        stream << layout << static_cast<qint32>(type->size()) << static_cast<qint32>(type->securityLevel())
+               << type->economy();
+        for(int image = 0; image < SettlementImageCount; image++) {
+            stream << type->imageSource(static_cast<SettlementImage>(image));
+        }
+    }
+
+    stream << static_cast<qint32>(routerSystems.size());
+    for(const auto &system: routerSystems) {
+        writeSystem(stream, system, typeIds);
+    }
+    stream << static_cast<qint32>(settlementSystems.size());
+    for(const auto &system: settlementSystems) {
+        writeSystem(stream, system, typeIds);
+    }
+    return stream.status() == QDataStream::Ok && file.commit();
+}
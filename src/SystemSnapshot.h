@@ -0,0 +1,53 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+class System;
+
+class SettlementType;
+
+typedef QList<System> SystemList;
+
+// The fully processed output of SystemLoader, stored in the cache directory. The router systems
+// are written in sorted order and the planet distances are already applied, so a warm start only
+// has to read the file back. The snapshot is tagged with a hash of the resource files it was
+// built from and is ignored as soon as any of them change.
+class SystemSnapshot {
+public:
+    explicit SystemSnapshot(const QByteArray &inputHash)
+            : _inputHash(inputHash) { }
+
+    static QByteArray hashResources(const QStringList &resources);
+
+    // Returns false if there is no snapshot for the input hash or it could not be read,
+    // in which case the output arguments are left empty.
+    bool load(SystemList &routerSystems, SystemList &settlementSystems,
+              QMap<QString, SettlementType *> &settlementTypes) const;
+
+    bool save(const SystemList &routerSystems, const SystemList &settlementSystems,
+              const QMap<QString, SettlementType *> &settlementTypes) const;
+
+private:
+    static QString path();
+
+    QByteArray _inputHash;
+};
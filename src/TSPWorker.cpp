@@ -44,56 +44,58 @@ namespace operations_research {
         return fromSystem.distance(toSystem);
     }
 
+    QVector<int64> TSPWorker::calculateDistanceRow(int from) {
+        // Only the upper triangle is calculated, the matrix is symmetric.
+        QVector<int64> row(_systems.size() - from - 1);
+        for(int to = from + 1; to < _systems.size(); to++) {
+            row[to - from - 1] = calculateDistance(from, to);
+        }
+        return row;
+    }
+
     void TSPWorker::calculateDistanceMatrix() {
         auto sz = _systems.size();
         _distanceMatrix.resize(sz);
-        typedef QPair<QFuture<int64>, QPair<int, int>> FuturePair;
-        QList<FuturePair> futures;
+        QList<QFuture<QVector<int64>>> futures;
 
         for(int from = 0; from < sz; from++) {
-            _distanceMatrix[from].fill(-1, sz);
+            _distanceMatrix[from].fill(0, sz);
         }
 
-        for(int from = 0; from < sz; from++) {
-            for(int to = 0; to < sz; to++) {
-                int64 dist = 0;
-                if(from != to) {
-                    if(_distanceMatrix[to][from] == -1) {
-                        auto future = QtConcurrent::run(this, &TSPWorker::calculateDistance, from, to);
-                        auto destPair = QPair<int, int>(from, to);
-                        futures.push_back(FuturePair(future, destPair));
-                        _distanceMatrix[to][from] = -2;
-                        _distanceMatrix[from][to] = -2;
-                        continue;
-                    }
-                } else {
-                    _distanceMatrix[from][to] = dist;
-                }
-            }
+        // One task per row on the shared scheduler rather than one per pair on the global
+        // QtConcurrent pool. If every pool thread is busy, waitForFinished() below runs
+        // the queued row in this thread instead of blocking.
+        auto pool = TaskScheduler::instance()->pool();
+        for(int from = 0; from < sz - 1; from++) {
+            futures.push_back(QtConcurrent::run(pool, this, &TSPWorker::calculateDistanceRow, from));
         }
         qDebug() << "Waiting for completion of" << futures.size() << "futures";
-        for(auto &pair: futures) {
-            pair.first.waitForFinished();
-            auto a = pair.second.first;
-            auto b = pair.second.second;
-            _distanceMatrix[a][b] = _distanceMatrix[b][a] = pair.first.result();
+        for(int from = 0; from < futures.size(); from++) {
+            auto &future = futures[from];
+            future.waitForFinished();
+            const auto row = future.result();
+            for(int i = 0; i < row.size(); i++) {
+                auto to = from + i + 1;
+                _distanceMatrix[from][to] = _distanceMatrix[to][from] = row[i];
+            }
         }
     }
 
     void TSPWorker::cylinder(QVector3D vec_from, QVector3D vec_to, float buffer) {
 
         auto bufferSquare = buffer * buffer;
-        typedef QPair<System,float> SystemDist;
-        QList<SystemDist> filteredSystems;
-            auto originDestDist = vec_from.distanceToPoint(vec_to)+buffer;
-        for(const auto &s: _systems) {
-            auto numerator = QVector3D::crossProduct(s.position() - vec_from, s.position() - vec_to).lengthSquared();
-            auto denominator = (vec_to - vec_from).lengthSquared();
+        typedef QPair<int,float> SystemDist;
+        QVector<SystemDist> filteredSystems;
+        auto originDestDist = vec_from.distanceToPoint(vec_to)+buffer;
+        auto denominator = (vec_to - vec_from).lengthSquared();
+        for(int i = 0; i < _systems.size(); i++) {
+            const auto &position = _systems[i].position();
+            auto numerator = QVector3D::crossProduct(position - vec_from, position - vec_to).lengthSquared();
             auto dist = numerator / denominator;
             if(dist < bufferSquare
-               && s.position().distanceToPoint(vec_from) < originDestDist
-               && s.position().distanceToPoint(vec_to) < originDestDist) {
-                filteredSystems.push_back(SystemDist(s, dist));
+               && position.distanceToPoint(vec_from) < originDestDist
+               && position.distanceToPoint(vec_to) < originDestDist) {
+                filteredSystems.push_back(SystemDist(i, dist));
             }
         }
         // qDebug() << "Cylinder of systems contain"<<filteredSystems.size()<<"nodes.";
@@ -101,13 +103,47 @@ namespace operations_research {
             return a.second < b.second;
         });
 
-        _systems.clear();
+        SystemList systems;
         for(int i = 0; i < filteredSystems.count() && i < _maxSystemCount; i++) {
-            _systems.push_back(filteredSystems[i].first);
+            systems.push_back(_systems[filteredSystems[i].first]);
         }
+        _systems = std::move(systems);
+    }
+
+    void TSPWorker::loadSettlementMatches() {
+        auto matches = _settlementMatches;
+        auto systemIndices = _settlementIndex.matchingSystems(matches);
+        if(_origin && !_destination && systemIndices.size() > _maxSystemCount) {
+            // Only the systems closest to the origin are routed, pick them before copying anything.
+            const auto &systems = *_settlementIndex.systems();
+            const auto origin = _origin;
+            std::partial_sort(systemIndices.begin(), systemIndices.begin() + _maxSystemCount, systemIndices.end(),
+                              [&systems, origin](int a, int b) {
+                                  return systems[a].distance(*origin) < systems[b].distance(*origin);
+                              });
+            QVector<bool> selected(systems.size(), false);
+            for(int i = 0; i < _maxSystemCount; i++) {
+                selected[systemIndices[i]] = true;
+            }
+            QVector<int> closestMatches;
+            for(auto match: matches) {
+                if(selected[_settlementIndex.systemIndex(match)]) {
+                    closestMatches.push_back(match);
+                }
+            }
+            matches = std::move(closestMatches);
+        }
+        _systems = _settlementIndex.systemsForMatches(matches);
     }
 
     void TSPWorker::run() {
+        if(_settlementIndex.systems()) {
+            loadSettlementMatches();
+        }
+        if(_systems.isEmpty()) {
+            emit taskCompleted(RouteResult());
+            return;
+        }
         System *startingSystem = _origin;
         if(!startingSystem) {
             startingSystem = &_systems[0];
@@ -187,8 +223,8 @@ namespace operations_research {
                     if(!sys.planets().size()) {
                         continue;
                     }
-                    for(auto planet: sys.planets()) {
-                        for(auto settlement: planet.settlements()) {
+                    for(const auto &planet: sys.planets()) {
+                        for(const auto &settlement: planet.settlements()) {
                             result.addEntry(sys, planet, settlement, dist);
 //                        out <<sys.name()<< "\t" << planet.name()<< "\t"<<settlement.name() << "\t" << dist<<endl;
                             dist = 0;
@@ -216,7 +252,7 @@ void RouteResult::addEntry(const System &system, int64 distance) {
     row[3] = system.formatPlanets();
     row[4] = QString("%1k").arg(estimatedValue);
     row[5] = QString("%1k").arg(_totalValue);
-    _route.emplace_back(row);
+    _route.emplace_back(std::move(row));
 }
 
 void RouteResult::addEntry(const System &system, const Planet &planet, const Settlement &settlement, int64 distance) {
@@ -227,10 +263,9 @@ void RouteResult::addEntry(const System &system, const Planet &planet, const Set
     row[2] = settlement.name();
     row[3] = System::formatDistance(distance);
     row[4] = System::formatDistance(_totalDist);
-    _route.emplace_back(row);
+    _route.emplace_back(std::move(row));
 
-    auto routeSettlement = RouteSystemPlanetSettlement(system.name(), planet.name(), planet.distance(), settlement);
-    _settlements.emplace_back(routeSettlement);
+    _settlements.emplace_back(system.name(), planet.name(), planet.distance(), settlement);
 }
 
 RouteResult::~RouteResult() {
@@ -37,10 +37,11 @@
 #pragma once
 
 #include <QList>
-#include <QThread>
+#include "TaskScheduler.h"
 #include <constraint_solver/routing.h>
 #include "System.h"
 #include "AStarRouter.h"
+#include "SettlementIndex.h"
 
 typedef std::vector<std::vector<QString>> RouteResultMatrix;
 
@@ -68,9 +69,9 @@ public:
     }
 
 private:
-    const QString _systemName;
-    const QString _planetName;
-    const Settlement _settlement;
+    QString _systemName;
+    QString _planetName;
+    Settlement _settlement;
     int _distance;
 };
 
@@ -114,17 +115,20 @@ private:
     int64 _totalValue;
 };
 
+class AllocationBenchmark; // tools/allocbench
+
 namespace operations_research {
-    class TSPWorker : public QThread {
+    class TSPWorker : public WorkerTask {
     Q_OBJECT
+        friend class ::AllocationBenchmark;
 
     public:
         TSPWorker(SystemList systems, System *system, int maxSystemCount)
-                : QThread(), _systems(systems), _origin(system), _destination(Q_NULLPTR), _maxSystemCount(maxSystemCount),
+                : WorkerTask(TaskPriorityBackground), _systems(systems), _origin(system), _destination(Q_NULLPTR), _maxSystemCount(maxSystemCount),
                   _router(Q_NULLPTR), _numDist(0), _systemsOnly(false) {}
 
 
-        virtual void run();
+        virtual void run() override;
 
 
         void setRouter(AStarRouter *router) {
@@ -139,6 +143,13 @@ namespace operations_research {
             _destination = destination;
         }
 
+        // Route over settlements selected from a SettlementIndex. Systems are only copied
+        // out of the index for the part of the matches that can end up in the route.
+        void setSettlementMatches(const SettlementIndex &index, const QVector<int> &matches) {
+            _settlementIndex = index;
+            _settlementMatches = matches;
+        }
+
     signals:
 
         void taskCompleted(const RouteResult &route);
@@ -150,8 +161,12 @@ namespace operations_research {
 
         int64 calculateDistance(int from, int to);
 
+        QVector<int64> calculateDistanceRow(int from);
+
         void cylinder(QVector3D vec_from, QVector3D vec_to, float buffer);
 
+        void loadSettlementMatches();
+
         SystemList _systems;
         System *_origin;
         System *_destination;
@@ -159,6 +174,8 @@ namespace operations_research {
         AStarRouter *_router;
         int _numDist;
         QVector<QVector<int64>> _distanceMatrix;
+        SettlementIndex _settlementIndex;
+        QVector<int> _settlementMatches;
 
         bool _systemsOnly;
     };
@@ -0,0 +1,53 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <QThread>
+#include "TaskScheduler.h"
+
+namespace {
+    // Runs a WorkerTask on a pool thread and signals completion. The task object itself
+    // is owned by its creator (usually deleted via finished() -> deleteLater()).
+    class WorkerTaskRunner : public QRunnable {
+    public:
+        explicit WorkerTaskRunner(WorkerTask *task) : QRunnable(), _task(task) { }
+
+        virtual void run() override {
+            _task->run();
+            emit _task->finished();
+        }
+
+    private:
+        WorkerTask *_task;
+    };
+}
+
+TaskScheduler *TaskScheduler::instance() {
+    static TaskScheduler scheduler;
+    return &scheduler;
+}
+
+TaskScheduler::TaskScheduler() : _pool() {
+    _pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+    _pool.setExpiryTimeout(60000);
+}
+
+void TaskScheduler::submit(QRunnable *task, TaskPriority priority) {
+    _pool.start(task, priority);
+}
+
+void WorkerTask::start() {
+    TaskScheduler::instance()->submit(new WorkerTaskRunner(this), _priority);
+}
@@ -0,0 +1,84 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+
+// Higher values are dequeued first. Interactive work (lookups the user is
+// waiting on) jumps ahead of queued route solves and data loading.
+enum TaskPriority {
+    TaskPriorityBackground = 0,
+    TaskPriorityNormal = 10,
+    TaskPriorityInteractive = 20
+};
+
+// Process wide worker pool shared by all windows. Sized to the hardware
+// concurrency so concurrent routing in several windows queues up rather than
+// oversubscribing the CPU with one OS thread per request.
+class TaskScheduler {
+public:
+    static TaskScheduler *instance();
+
+    void submit(QRunnable *task, TaskPriority priority = TaskPriorityNormal);
+
+    QThreadPool *pool() {
+        return &_pool;
+    }
+
+    int threadCount() const {
+        return _pool.maxThreadCount();
+    }
+
+private:
+    TaskScheduler();
+
+    QThreadPool _pool;
+};
+
+// Base for one-shot jobs that used to be QThread subclasses. Subclasses
+// implement run() as before, start() queues the job on the shared scheduler
+// and finished() is emitted from the worker thread once run() returns.
+class WorkerTask : public QObject {
+Q_OBJECT
+
+public:
+    explicit WorkerTask(TaskPriority priority = TaskPriorityNormal, QObject *parent = Q_NULLPTR)
+            : QObject(parent), _priority(priority) { }
+
+    virtual ~WorkerTask() override { }
+
+    void start();
+
+    virtual void run() = 0;
+
+    TaskPriority priority() const {
+        return _priority;
+    }
+
+    void setPriority(TaskPriority priority) {
+        _priority = priority;
+    }
+
+signals:
+
+    void finished();
+
+private:
+    TaskPriority _priority;
+};
@@ -0,0 +1,70 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <functional>
+#include "ValuableSystemIndex.h"
+#include "System.h"
+
+void ValuableSystemIndex::build(const SystemList &systems) {
+    typedef QPair<int32, const System *> ValueSystem;
+    QVector<ValueSystem> valuable;
+    for(const auto &system: systems) {
+        if(system.valuableBodyTypes()) {
+            valuable.push_back(ValueSystem(system.estimatedValue(), &system));
+        }
+    }
+    std::stable_sort(valuable.begin(), valuable.end(), [](const ValueSystem &a, const ValueSystem &b) {
+        return a.first > b.first;
+    });
+
+    _systems.clear();
+    _values.clear();
+    _types.clear();
+    _nameLookup.clear();
+    _systems.reserve(valuable.size());
+    _values.reserve(valuable.size());
+    _types.reserve(valuable.size());
+    for(const auto &entry: valuable) {
+        _values.push_back(entry.first);
+        _systems.push_back(entry.second);
+        _types.push_back(entry.second->valuableBodyTypes());
+        _nameLookup.insert(entry.second->name().toUpper(), _systems.size() - 1);
+    }
+}
+
+QVector<const System *> ValuableSystemIndex::filter(uint8_t typeMask, int32 minValue,
+                                                    const QBitArray *excludedSystems) const {
+    QVector<const System *> matches;
+    if(!typeMask) {
+        return matches;
+    }
+    // Values are sorted in descending order, everything before the bound is worth enough.
+    auto end = std::upper_bound(_values.constBegin(), _values.constEnd(), minValue, std::greater<int32>());
+    const auto count = static_cast<int>(end - _values.constBegin());
+    if(excludedSystems && excludedSystems->size() != _systems.size()) {
+        excludedSystems = nullptr; // Built against another index.
+    }
+    for(int i = 0; i < count; i++) {
+        if(!(_types[i] & typeMask)) {
+            continue;
+        }
+        if(excludedSystems && excludedSystems->testBit(i)) {
+            continue;
+        }
+        matches.push_back(_systems[i]);
+    }
+    return matches;
+}
@@ -0,0 +1,60 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QBitArray>
+#include <QHash>
+#include <QVector>
+#include <base/integral_types.h>
+
+class System;
+
+typedef QList<System> SystemList;
+
+// Only the systems with at least one valuable body, sorted by estimated value (highest first)
+// with one bit per ValuableBodyFlags type that is present. System pointers stay valid since
+// AStarRouter never removes systems and QList keeps large types in separate allocations.
+class ValuableSystemIndex {
+public:
+    ValuableSystemIndex() { }
+
+    void build(const SystemList &systems);
+
+    // Systems worth at least minValue with any of the body types in typeMask, skipping the
+    // systems whose bit is set in excludedSystems. Bits are indexed by position, see indicesOf().
+    QVector<const System *> filter(uint8_t typeMask, int32 minValue, const QBitArray *excludedSystems) const;
+
+    // Positions of the systems with the given name (any case). Names aren't unique, so there
+    // can be more than one.
+    QList<int> indicesOf(const QString &name) const {
+        return _nameLookup.values(name.toUpper());
+    }
+
+    int size() const {
+        return _systems.size();
+    }
+
+    static uint8_t typeBit(int type) {
+        return static_cast<uint8_t>(1 << type);
+    }
+
+private:
+    QVector<const System *> _systems;
+    QVector<int32> _values;
+    QVector<uint8_t> _types;
+    QMultiHash<QString, int> _nameLookup;
+};
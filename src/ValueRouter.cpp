@@ -1,7 +1,7 @@
 #include <QRadioButton>
 #include "ValueRouter.h"
 #include "ValuablePlanetRouteViewer.h"
-#include "MainWindow.h"
+#include "JournalService.h"
 
 
 ValueRouter::~ValueRouter() {
@@ -13,6 +13,8 @@ ValueRouter::ValueRouter(QWidget *parent, AStarRouter *router, SystemList *syste
     _systemsOnly = true;
     scanJournals();
     connect(_ui->rescanJournalButton, SIGNAL(clicked()), this, SLOT(scanJournals()));
+    connect(JournalService::instance(), &JournalService::loaded, this, &ValueRouter::scanJournals);
+    connect(JournalService::instance(), &JournalService::eventsReceived, this, &ValueRouter::handleEvents);
     connect(_ui->filterCommander, SIGNAL(currentTextChanged(const QString &)), this, SLOT(updateSystem()));
     updateFilters();
 
@@ -24,17 +26,22 @@ ValueRouter::ValueRouter(QWidget *parent, AStarRouter *router, SystemList *syste
 }
 
 void ValueRouter::scanJournals() {
+    // Anything found by the update is delivered to handleEvents().
+    auto journals = JournalService::instance();
+    journals->update();
+    if(!journals->isLoaded()) {
+        return; // Scanned again once loaded.
+    }
+    const auto state = journals->state();
     _commanderExploredSystems.clear();
-    _commanderInformation.clear();
-    QDir          dir(MainWindow::journalDirectory(), "Journal.*.log");
-    QFileInfoList list        = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::Files, QDir::Time | QDir::Reversed);
-
-    for(auto entry: list) {
-        auto file = entry.absoluteFilePath();
-        JournalFile journalFile(file);
-        connect(&journalFile, SIGNAL(onEvent(const JournalFile &, const Event &)), this, SLOT(handleEvent(const JournalFile &, const Event &)));
-        journalFile.parse();
+    const auto &exploredSystems = state.exploredSystems();
+    for(auto it = exploredSystems.constBegin(); it != exploredSystems.constEnd(); ++it) {
+        _commanderExploredSystems[it.key()];
+        for(const auto &system: it.value()) {
+            markExplored(it.key(), system);
+        }
     }
+    _commanderInformation = state.commanders();
     const auto comboBox = _ui->filterCommander;
     comboBox->clear();
     comboBox->addItems(_commanderExploredSystems.keys());
@@ -42,32 +49,94 @@ void ValueRouter::scanJournals() {
     updateFilters();
 }
 
-void ValueRouter::updateFilters() {
-    QList<bool> typeFilter;
+void ValueRouter::handleEvents(const JournalEventList &events) {
+    const auto selectedCommander = _ui->filterCommander->currentText();
+    bool exploredChanged = false;
+    bool locationChanged = false;
+    for(const auto &event: events) {
+        const auto &commander = event._context._commander;
+        if(commander.isEmpty() || event._context._system.isEmpty()) {
+            continue;
+        }
+        switch(event._type) {
+        case JournalEventScan:
+            if(markExplored(commander, event._context._system) && commander == selectedCommander) {
+                exploredChanged = true;
+            }
+            break;
+        case JournalEventLocation:
+        case JournalEventFSDJump:
+            _commanderExploredSystems[commander];
+            if(updateCommanderInfo(event) && commander == selectedCommander) {
+                locationChanged = true;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if(locationChanged) {
+        updateSystem();
+    }
+    if(exploredChanged && _ui->filterVisited->isChecked()) {
+        scheduleFilterUpdate();
+    }
+}
+
+bool ValueRouter::markExplored(const QString &commander, const QString &system) {
+    // Systems that aren't valuable are never in the filter results, so they aren't tracked.
+    const auto &valuableSystems = _router->valuableSystems();
+    const auto indices = valuableSystems.indicesOf(system);
+    auto &explored = _commanderExploredSystems[commander];
+    if(indices.isEmpty()) {
+        return false;
+    }
+    if(explored.size() != valuableSystems.size()) {
+        explored.resize(valuableSystems.size());
+    }
+    // The journal only has the name, so every system with that name counts as explored.
+    bool changed = false;
+    for(auto index: indices) {
+        if(!explored.testBit(index)) {
+            explored.setBit(index);
+            changed = true;
+        }
+    }
+    return changed;
+}
 
-    typeFilter.append(_ui->elw->isChecked());
-    typeFilter.append(_ui->ww->isChecked());
-    typeFilter.append(_ui->wwt->isChecked());
-    typeFilter.append(_ui->aw->isChecked());
-    typeFilter.append(_ui->tf->isChecked());
+void ValueRouter::updateFilters() {
+    uint8_t typeFilter = 0;
 
-    _filteredSystems.clear();
+    if(_ui->elw->isChecked()) { typeFilter |= ValuableSystemIndex::typeBit(ValuableBodyFlagsEW); }
+    if(_ui->ww->isChecked()) { typeFilter |= ValuableSystemIndex::typeBit(ValuableBodyFlagsWW); }
+    if(_ui->wwt->isChecked()) { typeFilter |= ValuableSystemIndex::typeBit(ValuableBodyFlagsWT); }
+    if(_ui->aw->isChecked()) { typeFilter |= ValuableSystemIndex::typeBit(ValuableBodyFlagsAW); }
+    if(_ui->tf->isChecked()) { typeFilter |= ValuableSystemIndex::typeBit(ValuableBodyFlagsTF); }
 
-    QSet<QString> *excludedSystems(nullptr);
+    const QBitArray *excludedSystems(nullptr);
     const QString &filterCommander = _ui->filterCommander->currentText();
     if(_ui->filterVisited->isChecked() && !filterCommander.isEmpty() &&
        _commanderExploredSystems.contains(filterCommander)) {
-        excludedSystems = &_commanderExploredSystems[filterCommander];
+        excludedSystems = &*_commanderExploredSystems.constFind(filterCommander);
     }
 
-    for(const auto &system : _router->systems()) {
-        if(system.matchesFilter(typeFilter) && system.estimatedValue() >= _ui->minSystemValue->value() &&
-           (!excludedSystems || !excludedSystems->contains(system.name().toUpper()))) {
-            _filteredSystems.append(system);
-        }
+    _matchingSystems = _router->valuableSystems().filter(typeFilter, _ui->minSystemValue->value(), excludedSystems);
+
+    _ui->statusBar->showMessage(QString("Filter matches %1 systems.").arg(_matchingSystems.size()));
+}
+
+bool ValueRouter::hasFilteredSystems() const {
+    return _matchingSystems.size() > 0;
+}
+
+TSPWorker *ValueRouter::createWorker(System *originSystem, int routeSize) {
+    SystemList systems;
+    systems.reserve(_matchingSystems.size());
+    for(auto system: _matchingSystems) {
+        systems.push_back(*system);
     }
-    
-    _ui->statusBar->showMessage(QString("Filter matches %1 systems.").arg(_filteredSystems.size()));
+    return new TSPWorker(systems, originSystem, routeSize);
 }
 
 void ValueRouter::onRouterCreated(TSPWorker *worker) {
@@ -85,29 +154,6 @@ void ValueRouter::routeCalculated(const RouteResult &route) {
     viewer->show();
 }
 
-void ValueRouter::handleEvent(const JournalFile &file, const Event &ev) {
-    const QString &commander = file.commander();
-    const QString &systemName = file.system();
-    if(commander.isEmpty() || systemName.isEmpty()) {
-        return;
-    }
-    switch(ev.type()) {
-    case EventTypeLocation:
-    case EventTypeFSDJump:
-        if(updateCommanderInfo(file, ev, commander)) {
-            if(!_commanderExploredSystems.contains(commander)) {
-                _commanderExploredSystems[commander] = QSet<QString>();
-            }
-        }
-        break;
-    case EventTypeScan:
-        _commanderExploredSystems[commander].insert(systemName.toUpper());
-        break;
-    default:
-        break;
-    }
-}
-
 void ValueRouter::updateSystem() {
     const QString &system = _commanderInformation[_ui->filterCommander->currentText()]._system;
     _ui->systemName->setText(system);
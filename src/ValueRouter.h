@@ -20,16 +20,25 @@ public:
     virtual ~ValueRouter();
 
 protected slots:
-    void handleEvent(const JournalFile &file, const Event &ev);
-
     void scanJournals();
+    void handleEvents(const JournalEventList &events);
     virtual void updateFilters() override;
     virtual void routeCalculated(const RouteResult &route) override;
     virtual void updateSystem();
     virtual void onRouterCreated(TSPWorker *worker) override;
 
+protected:
+    virtual bool hasFilteredSystems() const override;
+
+    virtual TSPWorker *createWorker(System *originSystem, int routeSize) override;
+
 private:
-    QMap<QString, QSet<QString>> _commanderExploredSystems;
+    // Returns true if the system wasn't explored by the commander before.
+    bool markExplored(const QString &commander, const QString &system);
+
+    // One bit per ValuableSystemIndex position.
+    QMap<QString, QBitArray> _commanderExploredSystems;
+    QVector<const System *> _matchingSystems;
     SystemEntryCoordinateResolver *_systemResolverDestination;
 };
 
@@ -24,6 +24,8 @@
 
 Q_DECLARE_METATYPE(RouteResult);
 Q_DECLARE_METATYPE(SystemList);
+Q_DECLARE_METATYPE(SettlementIndex);
+Q_DECLARE_METATYPE(System);
 
 // namespace operations_research
 
@@ -34,7 +36,11 @@ int main(int argc, char **argv) {
 
     qRegisterMetaType<RouteResult>();
     qRegisterMetaType<SystemList>();
+    qRegisterMetaType<SettlementIndex>();
+    qRegisterMetaType<System>();
     QApplication a(argc, argv);
+    QCoreApplication::setOrganizationDomain("hedbor.org");
+    QCoreApplication::setApplicationName("EDPathFinder");
     MainWindow w;
     QIcon icon("://icon512.png");
     w.setWindowIcon(icon);
@@ -0,0 +1,145 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Counts heap allocations in the settlement hot paths: loading, filtering as the main window
+// does, narrowing a route to a cylinder and adding route entries. Run it on a tree before and
+// after a change to the value types to compare.
+//
+// Qt containers and strings allocate through malloc and realloc rather than operator new, so
+// the C allocator itself is replaced (glibc only), which also covers operator new. Every malloc,
+// calloc and realloc counts as one allocation.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <QElapsedTimer>
+#include <src/System.h>
+#include <src/AStarRouter.h>
+#include <src/SettlementIndex.h>
+#include <src/TSPWorker.h>
+
+static std::atomic<size_t> allocationCount(0);
+static std::atomic<size_t> allocationBytes(0);
+
+#ifdef __GLIBC__
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void __libc_free(void *ptr);
+
+    void *malloc(size_t size) {
+        ++allocationCount;
+        allocationBytes += size;
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size) {
+        ++allocationCount;
+        allocationBytes += count * size;
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size) {
+        ++allocationCount;
+        allocationBytes += size;
+        return __libc_realloc(ptr, size);
+    }
+
+    void free(void *ptr) {
+        __libc_free(ptr);
+    }
+}
+#else
+#error "allocbench replaces the glibc allocator and only builds with glibc"
+#endif
+
+class AllocationScope {
+public:
+    explicit AllocationScope(const char *name)
+            : _name(name), _count(allocationCount), _bytes(allocationBytes) {
+        _timer.start();
+    }
+
+    ~AllocationScope() {
+        fprintf(stderr, "%-28s %10zu allocations %12zu bytes %8lld ms\n", _name, allocationCount - _count,
+                allocationBytes - _bytes, (long long) _timer.elapsed());
+    }
+
+private:
+    const char *_name;
+    size_t _count;
+    size_t _bytes;
+    QElapsedTimer _timer;
+};
+
+// Reaches TSPWorker::cylinder(), which is private.
+class AllocationBenchmark {
+public:
+    static void cylinder(TSPWorker &worker, const QVector3D &from, const QVector3D &to) {
+        worker.cylinder(from, to, 200);
+    }
+};
+
+int main() {
+    AStarRouter  router;
+    SystemLoader loader(&router);
+
+    {
+        AllocationScope scope("loadSettlements");
+        loader.loadSettlements();
+    }
+    const auto &systems = loader.systems();
+    const auto &index = loader.settlementIndex();
+    fprintf(stderr, "%d systems, %d settlements\n", systems.size(), index.size());
+
+    // What MainWindow::updateFilters() does after reading the widgets.
+    QVector<int> matches;
+    {
+        AllocationScope scope("updateFilters");
+        matches = index.filter(SettlementFilter());
+        fprintf(stderr, "%d matching systems\n", index.countSystems(matches));
+    }
+
+    SystemList filtered;
+    {
+        AllocationScope scope("systemsForMatches");
+        filtered = index.systemsForMatches(matches);
+    }
+    if(filtered.size() < 2) {
+        return 1;
+    }
+
+    {
+        TSPWorker worker(filtered, nullptr, 100);
+        AllocationScope scope("TSPWorker::cylinder");
+        AllocationBenchmark::cylinder(worker, filtered.first().position(), filtered.last().position());
+    }
+
+    {
+        AllocationScope scope("RouteResult::addEntry");
+        RouteResult result;
+        for(const auto &system: filtered) {
+            for(const auto &planet: system.planets()) {
+                for(const auto &settlement: planet.settlements()) {
+                    result.addEntry(system, planet, settlement, 0);
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -14,132 +14,128 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+// Builds resources/body_distances.tsv from the EDSM systems_populated.jsonl and bodies.jsonl
+// dumps in the current directory. Both files are memory mapped and scanned in parallel chunks,
+// only the settlement systems are kept from the system dump and only the fields needed are
+// extracted from each body.
+
+#include <atomic>
+#include <functional>
+#include <iostream>
 #include <QDebug>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QHash>
+#include <QMap>
+#include <QtConcurrent>
 #include <src/System.h>
 #include <src/AStarRouter.h>
+#include <tools/common/JsonScanner.h>
+
+typedef QPair<QString, QString> BodyName;
+
+struct BodyDistance {
+    BodyName body;
+    int distance;
+};
 
 int main() {
     AStarRouter  router;
     SystemLoader loader(&router);
 
     loader.loadSettlements();
-    auto systems                                   = loader.systems();
+    const auto &systems = loader.systems();
     qDebug() << systems.size();
 
-    QMap<QString, QMap<QString, QPair<QString,QString>>> bodyLookup;
-    int                                  bodycount = 0;
-    for(auto                             system: systems) {
-        for(auto planet: system.planets()) {
-            bodyLookup[system.name().toLower()][planet.name().toLower()] = QPair<QString,QString>(system.name(), planet.name());
+    // Lowercase system name -> lowercase planet name -> names as spelled in the settlement data.
+    QHash<QString, QHash<QString, BodyName>> bodyLookup;
+    int bodycount = 0;
+    for(const auto &system: systems) {
+        auto &planets = bodyLookup[system.name().toLower()];
+        for(const auto &planet: system.planets()) {
+            planets[planet.name().toLower()] = BodyName(system.name(), planet.name());
         }
         bodycount++;
     }
     qDebug() << "Found" << bodycount << "bodies";
-    QMap<int, QString> systemIdToName;
-    QFile              file("systems_populated.jsonl");
-    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    const auto &settlementBodies = bodyLookup; // Shared read only between the chunk workers.
+
+    MappedFile systemFile("systems_populated.jsonl");
+    if(!systemFile.isValid()) {
         qDebug() << "Couldn't open file for reading.";
         return -1;
     }
-    int found = 0;
-    int numLines = 0;
-    while(!file.atEnd()) {
-        auto lineBytes = file.readLine();
-        if(lineBytes.isEmpty()) {
-            continue;
-        }
-        auto doc = QJsonDocument::fromJson(lineBytes);
-        if(doc.isEmpty() || !doc.isObject()) {
-            continue;
-        }
-        auto    jsonObject = doc.object();
-        int     id         = jsonObject.value("id").toInt(0);
-        QString name       = jsonObject.value("name").toString();
-        if(id && !name.isEmpty()) {
-            systemIdToName[id] = name.toLower();
-            if(bodyLookup.contains(name.toLower())) {
-                ++found;
-            }
-        }
-    }
-    qDebug() << "Loaded" << systemIdToName.size() << "system ids" << "and found" << found;
-
+    typedef QHash<int, QString> SystemIds;
+    auto systemIdToName = QtConcurrent::blockingMappedReduced<SystemIds>(
+            splitLines(systemFile.data(), systemFile.size()),
+            std::function<SystemIds(const JsonChunk &)>([&settlementBodies](const JsonChunk &chunk) {
+                SystemIds ids;
+                forEachLine(chunk, [&](const char *begin, const char *end) {
+                    const auto id = static_cast<int>(readJsonInt(findJsonValue(begin, end, "id"), end));
+                    if(!id) {
+                        return;
+                    }
+                    const auto name = readJsonString(findJsonValue(begin, end, "name"), end).toLower();
+                    if(settlementBodies.contains(name)) {
+                        ids[id] = name;
+                    }
+                });
+                return ids;
+            }),
+            [](SystemIds &result, const SystemIds &ids) {
+                result.unite(ids);
+            });
+    qDebug() << "Found" << systemIdToName.size() << "settlement system ids";
 
-    file.close();
-    QFile bodies("bodies.jsonl");
-    if(!bodies.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    MappedFile bodies("bodies.jsonl");
+    if(!bodies.isValid()) {
         qDebug() << "Couldn't open file for reading.";
         return -1;
     }
-    int systemmatch = 0;
-    int                  i = 0;
-    QList<QFuture<void>> futures;
-    QMap<QString,QMap<QString,int>> distances;
-    qint64 numReadBytes(0);
-    while(!bodies.atEnd()) {
-
-        auto linebytes = bodies.readLine();
-        numReadBytes += linebytes.size() + 1;
-        if(!(++numLines%10000)) {
-            fprintf(stderr, "\rLines parsed: %7d (%3d%%)", numLines, (int) (numReadBytes / (double)bodies.size() * 100));
-            fflush(stderr);
-        }
-
-        if(linebytes.isEmpty()) {
-            continue;
-        }
-        auto doc = QJsonDocument::fromJson(linebytes);
-        if(!doc.isObject()) {
-            continue;
-        }
-        auto jsonObject = doc.object();
-        int  dist       = jsonObject.value("distance_to_arrival").toInt(0);
-        if(!dist) {
-            continue;
-        }
-        int id = jsonObject.value("system_id").toInt(0);
-        if(!systemIdToName.contains(id)) {
-            continue;
-        }
-        auto    system = systemIdToName[id];
-        QString name   = jsonObject.value("name").toString().toLower();
-        name.replace(system + " ", "");
-        if(bodyLookup.contains(system)) {
-            systemmatch++;
-            if(bodyLookup[system].contains(name)) {
-                auto info = bodyLookup[system][name];
-                distances[info.first][info.second] = dist;
-                ++i;
-            }
-        }
-    }
-    QJsonDocument outputDocument;
-    QJsonObject rootObject;
-    for(auto system: distances.keys()) {
-        QJsonObject systemObject;
-        auto sysmap = distances[system];
-        for(auto planet: sysmap.keys()) {
-            systemObject.insert(planet, QJsonValue(sysmap[planet]));
-        }
-        rootObject.insert(system, systemObject);
-    }
-    outputDocument.setObject(rootObject);
-    fprintf(stderr, "\rLines parsed: %-7d            \n", numLines);
-
-
-    std::cout << QString(outputDocument.toJson(QJsonDocument::Compact)).toStdString() << std::endl;
+    std::atomic<qint64> numReadBytes(0);
+    const auto totalBytes = bodies.size();
+    typedef QVector<BodyDistance> BodyDistances;
+    typedef QMap<QString, QMap<QString, int>> DistanceMap;
+    // Chunks are reduced in file order so later entries for a body replace earlier ones.
+    auto distances = QtConcurrent::blockingMappedReduced<DistanceMap>(
+            splitLines(bodies.data(), totalBytes),
+            std::function<BodyDistances(const JsonChunk &)>([&](const JsonChunk &chunk) {
+                BodyDistances found;
+                forEachLine(chunk, [&](const char *begin, const char *end) {
+                    const auto dist = static_cast<int>(readJsonInt(findJsonValue(begin, end, "distance_to_arrival"), end));
+                    if(!dist) {
+                        return;
+                    }
+                    const auto id = static_cast<int>(readJsonInt(findJsonValue(begin, end, "system_id"), end));
+                    const auto system = systemIdToName.constFind(id);
+                    if(system == systemIdToName.constEnd()) {
+                        return;
+                    }
+                    auto name = readJsonString(findJsonValue(begin, end, "name"), end).toLower();
+                    name.replace(*system + " ", "");
+                    const auto &planets = *settlementBodies.constFind(*system);
+                    const auto planet = planets.constFind(name);
+                    if(planet != planets.constEnd()) {
+                        found.push_back({*planet, dist});
+                    }
+                });
+                numReadBytes += chunk.end - chunk.begin;
+                return found;
+            }),
+            [&](DistanceMap &result, const BodyDistances &found) {
+                for(const auto &entry: found) {
+                    result[entry.body.first][entry.body.second] = entry.distance;
+                }
+                fprintf(stderr, "\rParsed: %3d%%", (int) (numReadBytes / (double) totalBytes * 100));
+                fflush(stderr);
+            }, QtConcurrent::OrderedReduce);
+    fprintf(stderr, "\rParsed: 100%%\n");
 
-    #if 0
-    for(auto s: bodyLookup.keys()) {
-        for(auto p: bodyLookup[s].keys()) {
-            if(!bodyLookup[s][p]) {
-                qDebug() << "--- MISSING"<<s<<p;
-            }
+    // Same format as resources/body_distances.tsv, read by BodyDistances.
+    for(auto system = distances.constBegin(); system != distances.constEnd(); ++system) {
+        for(auto planet = system.value().constBegin(); planet != system.value().constEnd(); ++planet) {
+            std::cout << system.key().toStdString() << '\t' << planet.key().toStdString() << '\t'
+                      << planet.value() << '\n';
         }
     }
-#endif
-//    qDebug() << "Looked at" << i << "bodies today and found"<<systemmatch<<"matching systems";
+    std::cout.flush();
     return 0;
 }
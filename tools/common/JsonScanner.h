@@ -0,0 +1,171 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Helpers for the data conversion tools, which read EDSM dumps that are far too large to run
+// through QJsonDocument line by line. Input files are memory mapped and split into chunks on
+// line boundaries so they can be scanned in parallel, and only the requested fields are pulled
+// out of each line. Fields are matched on their first occurrence in the line, which for the EDSM
+// dumps is always the top level one since nested objects come after the plain fields.
+
+#pragma once
+
+#include <cstring>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QString>
+#include <QVector>
+
+struct JsonChunk {
+    const char *begin;
+    const char *end;
+};
+
+// Split [data, data + size) into chunks of roughly chunkSize bytes, each ending after a newline.
+inline QVector<JsonChunk> splitLines(const char *data, qint64 size, qint64 chunkSize = 32 * 1024 * 1024) {
+    QVector<JsonChunk> chunks;
+    const char *pos = data;
+    const char *end = data + size;
+    while(pos < end) {
+        const char *chunkEnd = end - pos > chunkSize ? pos + chunkSize : end;
+        if(chunkEnd < end) {
+            auto newline = static_cast<const char *>(memchr(chunkEnd, '\n', end - chunkEnd));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+        chunks.push_back({pos, chunkEnd});
+        pos = chunkEnd;
+    }
+    return chunks;
+}
+
+// Calls fn(lineBegin, lineEnd) for every non empty line in the chunk.
+template<typename Fn>
+inline void forEachLine(const JsonChunk &chunk, Fn fn) {
+    const char *pos = chunk.begin;
+    while(pos < chunk.end) {
+        auto lineEnd = static_cast<const char *>(memchr(pos, '\n', chunk.end - pos));
+        if(!lineEnd) {
+            lineEnd = chunk.end;
+        }
+        if(lineEnd > pos) {
+            fn(pos, lineEnd);
+        }
+        pos = lineEnd + 1;
+    }
+}
+
+// Returns a pointer to the value of the first "key" in the line, or nullptr.
+inline const char *findJsonValue(const char *begin, const char *end, const char *key) {
+    const auto keyLength = strlen(key);
+    const char *pos = begin;
+    while(pos < end) {
+        auto quote = static_cast<const char *>(memchr(pos, '"', end - pos));
+        if(!quote) {
+            return nullptr;
+        }
+        auto nameEnd = quote + 1 + keyLength;
+        if(nameEnd < end && *nameEnd == '"' && !memcmp(quote + 1, key, keyLength)) {
+            auto value = nameEnd + 1;
+            while(value < end && (*value == ' ' || *value == '\t')) { ++value; }
+            if(value < end && *value == ':') {
+                ++value;
+                while(value < end && (*value == ' ' || *value == '\t')) { ++value; }
+                return value;
+            }
+        }
+        pos = quote + 1;
+    }
+    return nullptr;
+}
+
+// Integer part of a numeric value, 0 for null or anything that is not a number.
+inline qint64 readJsonInt(const char *value, const char *end) {
+    if(!value) {
+        return 0;
+    }
+    bool negative = value < end && *value == '-';
+    if(negative) {
+        ++value;
+    }
+    qint64 result = 0;
+    for(; value < end && *value >= '0' && *value <= '9'; ++value) {
+        result = result * 10 + (*value - '0');
+    }
+    return negative ? -result : result;
+}
+
+// The number exactly as written in the input, empty if the value is not a number.
+inline QByteArray readJsonNumberText(const char *value, const char *end) {
+    if(!value || value >= end || !(*value == '-' || (*value >= '0' && *value <= '9'))) {
+        return QByteArray();
+    }
+    const char *numberEnd = value;
+    while(numberEnd < end && *numberEnd && strchr("+-0123456789.eE", *numberEnd)) { ++numberEnd; }
+    return QByteArray(value, static_cast<int>(numberEnd - value));
+}
+
+// String value, a null QString if the value isn't a string. Strings with escapes are rare
+// and handed to QJsonDocument instead of being decoded here.
+inline QString readJsonString(const char *value, const char *end) {
+    if(!value || value >= end || *value != '"') {
+        return QString();
+    }
+    const char *pos = value + 1;
+    bool escaped = false;
+    while(pos < end && *pos != '"') {
+        if(*pos == '\\') {
+            escaped = true;
+            ++pos;
+        }
+        ++pos;
+    }
+    if(pos >= end) {
+        return QString();
+    }
+    if(!escaped) {
+        return QString::fromUtf8(value + 1, static_cast<int>(pos - value - 1));
+    }
+    QByteArray array("[");
+    array.append(value, static_cast<int>(pos - value + 1));
+    array.append(']');
+    return QJsonDocument::fromJson(array).array().at(0).toString();
+}
+
+// Maps a whole input file. The mapping stays valid as long as the MappedFile exists.
+class MappedFile {
+public:
+    explicit MappedFile(const QString &path) : _file(path), _data(nullptr) {
+        if(_file.open(QIODevice::ReadOnly) && _file.size() > 0) {
+            _data = reinterpret_cast<const char *>(_file.map(0, _file.size()));
+        }
+    }
+
+    bool isValid() const {
+        return _data != nullptr;
+    }
+
+    const char *data() const {
+        return _data;
+    }
+
+    qint64 size() const {
+        return _file.size();
+    }
+
+private:
+    QFile _file;
+    const char *_data;
+};
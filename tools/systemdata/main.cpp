@@ -0,0 +1,374 @@
+//
+//  Copyright (C) 2017  David Hedbor <neotron@gmail.com>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Regenerates resources/systems.txt.gz and resources/valuable-systems.csv.gz from the EDSM dumps.
+//
+//   systemdata [systems.json] [valuable-bodies.jsonl] [systems.csv] [elws.txt]
+//
+// systems.json (one system object per line) becomes systems.txt.gz with one
+// "name<TAB>x<TAB>y<TAB>z" line per system, and systems.index, the sorted coordinate index the
+// application resolves unknown systems from when it's copied to its data directory (see
+// CoordinateIndex). valuable-bodies.jsonl is aggregated into per system
+// body counts, which are joined with the coordinates in systems.csv to build
+// valuable-systems.csv.gz. Systems listed in elws.txt without any other body data are added as
+// having one Earth-like world. All inputs are memory mapped and scanned in parallel chunks, the
+// output is compressed as it is produced, and the coordinate index is sorted in bounded memory
+// through temporary files.
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+#include <QByteArray>
+#include <QDebug>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QtConcurrent>
+#ifdef Q_OS_WIN
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+#include <tools/common/JsonScanner.h>
+#include <src/CoordinateIndex.h>
+
+// Sorted runs of the coordinate index are written once they take about this much memory.
+#define INDEX_RUN_BYTES (256 * 1024 * 1024)
+// Rough heap overhead of one QByteArray line on top of its characters.
+#define INDEX_LINE_OVERHEAD 32
+
+namespace {
+    enum BodyCount {
+        BodyCountEW,
+        BodyCountWW,
+        BodyCountWT,
+        BodyCountAW,
+        BodyCountTF,
+        BodyCountTotal
+    };
+
+    typedef std::array<int, BodyCountTotal> BodyCounts;
+    typedef QHash<int, BodyCounts> SystemBodyCounts;
+
+    class GzipWriter {
+    public:
+        explicit GzipWriter(const QString &path) : _file(gzopen(path.toLocal8Bit().constData(), "wb9")) { }
+
+        ~GzipWriter() {
+            if(_file) {
+                gzclose(_file);
+            }
+        }
+
+        bool isValid() const {
+            return _file != nullptr;
+        }
+
+        void write(const QByteArray &data) {
+            if(!data.isEmpty()) {
+                gzwrite(_file, data.constData(), static_cast<unsigned>(data.size()));
+            }
+        }
+
+    private:
+        gzFile _file;
+    };
+
+    struct SystemLines {
+        QByteArray _lines;
+        QVector<QByteArray> _indexLines;
+    };
+
+    // Keys come first on each line and are followed by a tab, which sorts before any character
+    // in a name, so comparing whole lines orders them by key.
+    bool indexLineLess(const QByteArray &a, const QByteArray &b) {
+        const auto compare = memcmp(a.constData(), b.constData(), static_cast<size_t>(qMin(a.size(), b.size())));
+        return compare ? compare < 0 : a.size() < b.size();
+    }
+
+    // External merge sort of the coordinate index lines. Lines are collected into runs of bounded
+    // size, each run is sorted and written to a temporary file next to the output, and the runs
+    // are merged into the index at the end. Memory use doesn't grow with the size of the dump.
+    class IndexSorter {
+    public:
+        explicit IndexSorter(const QString &output)
+                : _output(output), _runDir(QFileInfo(output).absolutePath() + "/systemdata-XXXXXX"), _runs(),
+                  _lines(), _bytes(0), _count(0), _ok(true) { }
+
+        bool isValid() const {
+            return _runDir.isValid();
+        }
+
+        void add(const QVector<QByteArray> &lines) {
+            for(const auto &line: lines) {
+                _lines.push_back(line);
+                _bytes += line.size() + INDEX_LINE_OVERHEAD;
+            }
+            _count += lines.size();
+            if(_bytes >= INDEX_RUN_BYTES) {
+                writeRun();
+            }
+        }
+
+        bool finish() {
+            writeRun();
+            if(!_ok) {
+                qDebug() << "Couldn't write the sorted runs for" << _output;
+                return false;
+            }
+            QFile output(_output);
+            if(!output.open(QIODevice::WriteOnly)) {
+                qDebug() << "Couldn't write" << _output;
+                return false;
+            }
+            // Merge the runs through a heap holding the next line of each one.
+            typedef QPair<QByteArray, int> RunLine;
+            auto greater = [](const RunLine &a, const RunLine &b) {
+                return indexLineLess(b.first, a.first);
+            };
+            std::priority_queue<RunLine, std::vector<RunLine>, decltype(greater)> heap(greater);
+            std::vector<std::unique_ptr<QFile>> runs;
+            for(const auto &path: _runs) {
+                runs.emplace_back(new QFile(path));
+                if(!runs.back()->open(QIODevice::ReadOnly)) {
+                    qDebug() << "Couldn't read" << path;
+                    return false;
+                }
+                if(!runs.back()->atEnd()) {
+                    heap.push(RunLine(runs.back()->readLine(), static_cast<int>(runs.size() - 1)));
+                }
+            }
+            while(!heap.empty()) {
+                const auto next = heap.top();
+                heap.pop();
+                output.write(next.first);
+                auto &run = runs[static_cast<size_t>(next.second)];
+                if(!run->atEnd()) {
+                    heap.push(RunLine(run->readLine(), next.second));
+                }
+            }
+            fprintf(stderr, "Wrote %d systems to %s\n", _count, qPrintable(_output));
+            return true;
+        }
+
+    private:
+        void writeRun() {
+            if(_lines.isEmpty()) {
+                return;
+            }
+            std::sort(_lines.begin(), _lines.end(), indexLineLess);
+            const auto path = _runDir.path() + QString("/run%1").arg(_runs.size());
+            QFile file(path);
+            if(!file.open(QIODevice::WriteOnly)) {
+                _ok = false;
+            } else {
+                for(const auto &line: _lines) {
+                    _ok &= file.write(line) == line.size();
+                }
+            }
+            _runs.push_back(path);
+            _lines.clear();
+            _bytes = 0;
+        }
+
+        QString _output;
+        QTemporaryDir _runDir;
+        QStringList _runs;
+        QVector<QByteArray> _lines;
+        qint64 _bytes;
+        int _count;
+        bool _ok;
+    };
+
+    bool convertSystems(const QString &input, const QString &output, const QString &indexOutput) {
+        MappedFile systems(input);
+        GzipWriter writer(output);
+        if(!systems.isValid() || !writer.isValid()) {
+            qDebug() << "Couldn't convert" << input << "to" << output;
+            return false;
+        }
+        IndexSorter index(indexOutput);
+        if(!index.isValid()) {
+            qDebug() << "Couldn't create a temporary directory for" << indexOutput;
+            return false;
+        }
+        int count = 0;
+        QtConcurrent::blockingMappedReduced<int>(
+                splitLines(systems.data(), systems.size()),
+                std::function<SystemLines(const JsonChunk &)>([](const JsonChunk &chunk) {
+                    SystemLines result;
+                    forEachLine(chunk, [&](const char *begin, const char *end) {
+                        const auto name = readJsonString(findJsonValue(begin, end, "name"), end);
+                        const auto coords = findJsonValue(begin, end, "coords");
+                        if(name.isEmpty() || !coords) {
+                            return;
+                        }
+                        const auto x = readJsonNumberText(findJsonValue(coords, end, "x"), end);
+                        const auto y = readJsonNumberText(findJsonValue(coords, end, "y"), end);
+                        const auto z = readJsonNumberText(findJsonValue(coords, end, "z"), end);
+                        if(x.isEmpty() || y.isEmpty() || z.isEmpty()) {
+                            return;
+                        }
+                        const auto line = name.toUtf8() + '\t' + x + '\t' + y + '\t' + z + '\n';
+                        result._lines += line;
+                        result._indexLines.push_back(CoordinateIndex::key(name) + '\t' + line);
+                    });
+                    return result;
+                }),
+                [&](int &, const SystemLines &lines) {
+                    writer.write(lines._lines);
+                    index.add(lines._indexLines);
+                    count += lines._indexLines.size();
+                    fprintf(stderr, "\rSystems: %d", count);
+                    fflush(stderr);
+                }, QtConcurrent::OrderedReduce | QtConcurrent::SequentialReduce);
+        fprintf(stderr, "\rWrote %d systems to %s\n", count, qPrintable(output));
+        return index.finish();
+    }
+
+    SystemBodyCounts loadBodyCounts(const QString &input) {
+        MappedFile bodies(input);
+        if(!bodies.isValid()) {
+            qDebug() << "Couldn't open" << input;
+            return SystemBodyCounts();
+        }
+        return QtConcurrent::blockingMappedReduced<SystemBodyCounts>(
+                splitLines(bodies.data(), bodies.size()),
+                std::function<SystemBodyCounts(const JsonChunk &)>([](const JsonChunk &chunk) {
+                    SystemBodyCounts counts;
+                    forEachLine(chunk, [&](const char *begin, const char *end) {
+                        const auto systemId = static_cast<int>(readJsonInt(findJsonValue(begin, end, "system_id"), end));
+                        if(!systemId) {
+                            return;
+                        }
+                        auto &systemCounts = counts[systemId];
+                        const auto type = readJsonString(findJsonValue(begin, end, "type_name"), end);
+                        const bool terraformable =
+                                readJsonInt(findJsonValue(begin, end, "terraforming_state_id"), end) == 2;
+                        if(type == "Earth-like world") {
+                            ++systemCounts[BodyCountEW];
+                        } else if(type == "Water world") {
+                            ++systemCounts[BodyCountWW];
+                            if(terraformable) {
+                                ++systemCounts[BodyCountWT];
+                            }
+                        } else if(type == "Ammonia world") {
+                            ++systemCounts[BodyCountAW];
+                        } else if(terraformable) {
+                            ++systemCounts[BodyCountTF];
+                        }
+                    });
+                    return counts;
+                }),
+                [&](SystemBodyCounts &result, const SystemBodyCounts &counts) {
+                    for(auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+                        auto &systemCounts = result[it.key()];
+                        for(int i = 0; i < BodyCountTotal; i++) {
+                            systemCounts[i] += it.value()[i];
+                        }
+                    }
+                    fprintf(stderr, "\rValuable systems: %d", result.size());
+                    fflush(stderr);
+                });
+    }
+
+    QSet<QString> loadSystemNames(const QString &input) {
+        QSet<QString> names;
+        QFile file(input);
+        if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return names;
+        }
+        while(!file.atEnd()) {
+            const auto name = QString::fromLatin1(file.readLine()).trimmed().toUpper();
+            if(!name.isEmpty()) {
+                names.insert(name);
+            }
+        }
+        return names;
+    }
+
+    bool writeValuableSystems(const QString &input, const QString &output, const SystemBodyCounts &bodyCounts,
+                              const QSet<QString> &elwSystems) {
+        MappedFile systems(input);
+        GzipWriter writer(output);
+        if(!systems.isValid() || !writer.isValid()) {
+            qDebug() << "Couldn't convert" << input << "to" << output;
+            return false;
+        }
+        int count = 0;
+        QtConcurrent::blockingMappedReduced<int>(
+                splitLines(systems.data(), systems.size()),
+                std::function<QByteArray(const JsonChunk &)>([&](const JsonChunk &chunk) {
+                    QByteArray lines;
+                    forEachLine(chunk, [&](const char *begin, const char *end) {
+                        // id, edsm_id, name, x, y, z, ..., and a column that must be 0 at index 7.
+                        const auto row = QByteArray::fromRawData(begin, static_cast<int>(end - begin)).split(',');
+                        if(row.size() < 8 || row[7].trimmed() != "0") {
+                            return;
+                        }
+                        bool ok;
+                        const auto id = row[0].toInt(&ok);
+                        if(!ok) {
+                            return;
+                        }
+                        const auto name = QString::fromUtf8(row[2]).remove('"');
+                        auto counts = bodyCounts.constFind(id);
+                        BodyCounts systemCounts;
+                        if(counts != bodyCounts.constEnd()) {
+                            systemCounts = *counts;
+                        } else if(elwSystems.contains(name.toUpper())) {
+                            systemCounts = {{1, 0, 0, 0, 0}};
+                        } else {
+                            return;
+                        }
+                        lines += name.toUtf8() + '\t' + row[3] + '\t' + row[4] + '\t' + row[5];
+                        for(auto value: systemCounts) {
+                            lines += '\t' + QByteArray::number(value);
+                        }
+                        lines += '\n';
+                    });
+                    return lines;
+                }),
+                [&](int &, const QByteArray &lines) {
+                    writer.write(lines);
+                    count += lines.count('\n');
+                }, QtConcurrent::OrderedReduce | QtConcurrent::SequentialReduce);
+        fprintf(stderr, "\rWrote %d valuable systems to %s\n", count, qPrintable(output));
+        return true;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const QString systemsJson = argc > 1 ? argv[1] : "systems.json";
+    const QString valuableBodies = argc > 2 ? argv[2] : "valuable-bodies.jsonl";
+    const QString systemsCsv = argc > 3 ? argv[3] : "systems.csv";
+    const QString elws = argc > 4 ? argv[4] : "elws.txt";
+
+    if(!convertSystems(systemsJson, "systems.txt.gz", "systems.index")) {
+        return 1;
+    }
+    const auto bodyCounts = loadBodyCounts(valuableBodies);
+    fprintf(stderr, "\rParsed bodies in %d systems.\n", bodyCounts.size());
+    if(!writeValuableSystems(systemsCsv, "valuable-systems.csv.gz", bodyCounts, loadSystemNames(elws))) {
+        return 1;
+    }
+    return 0;
+}